@@ -0,0 +1,118 @@
+#ifndef BATCHED_PROBE_H
+#define BATCHED_PROBE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// -- Batched probing with software prefetching (group prefetching) --
+//
+// A plain probe loop stalls on one dependent cache miss per key once the hash
+// table no longer fits in cache. Here the probe rows are taken in batches: the
+// first pass hashes every key of the batch and prefetches its bucket, the second
+// resolves them, by which time most buckets are on their way from memory.
+// Any table with prefetch(key) (FlatHashMap, SwissHashMap, DenseArrayMap,
+// CsrHashTable, SwissJoinTable) can be probed this way. A table whose matches
+// live behind its bucket (CsrHashTable: offsets, then entries) also has
+// prefetch_matches(key), a second stage run once the whole batch's buckets are
+// in cache: it reads the bucket and prefetches the matches, so the second
+// dependent miss is overlapped across the batch as well.
+
+constexpr size_t kDefaultProbeBatch = 16;
+
+template <typename Table, typename Key, typename = void>
+struct HasPrefetchMatches : std::false_type {};
+
+template <typename Table, typename Key>
+struct HasPrefetchMatches<Table, Key, std::void_t<decltype(std::declval<const Table&>().prefetch_matches(std::declval<Key>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Calls prefetch_matches(key) on tables that have it; a no-op for the others.
+ */
+template <typename Table, typename Key>
+inline void prefetch_matches(const Table& table, Key key) {
+    if constexpr (HasPrefetchMatches<Table, Key>::value) {
+        table.prefetch_matches(key);
+    }
+}
+
+/**
+ * @brief Calls probe(row) for rows[0..count), prefetching each batch's buckets first.
+ * @param table The table being probed; only its prefetch(key) is used here.
+ * @param rows The probe rows.
+ * @param count Number of probe rows.
+ * @param batch Keys prefetched ahead of resolving them; 0 or 1 probes one row at a time.
+ * @param key_of Callable (const Row&) -> key.
+ * @param probe Callable (const Row&) that looks the row up in table.
+ */
+template <typename Table, typename Row, typename KeyFn, typename ProbeFn>
+void probe_batched(const Table& table, const Row* rows, size_t count, size_t batch, KeyFn key_of, ProbeFn probe) {
+    if (batch <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            probe(rows[i]);
+        }
+        return;
+    }
+    for (size_t start = 0; start < count; start += batch) {
+        size_t stop = std::min(count, start + batch);
+        for (size_t i = start; i < stop; ++i) {
+            table.prefetch(key_of(rows[i]));
+        }
+        for (size_t i = start; i < stop; ++i) {
+            prefetch_matches(table, key_of(rows[i]));
+        }
+        for (size_t i = start; i < stop; ++i) {
+            probe(rows[i]);
+        }
+    }
+}
+
+/**
+ * @brief Like probe_batched, but only rows whose key passes filter are probed. Each batch is
+ * checked against the filter first (its blocks prefetched), then the table buckets of the keys
+ * that passed are prefetched and resolved, so the filtered probes keep their prefetching.
+ * @param filter A filter with prefetch(key) and may_contain(key), e.g. BlockedBloomFilter.
+ * @see probe_batched for the other parameters.
+ * @return The number of rows that passed the filter.
+ */
+template <typename Filter, typename Table, typename Row, typename KeyFn, typename ProbeFn>
+size_t probe_batched_filtered(const Filter& filter, const Table& table, const Row* rows, size_t count, size_t batch,
+                              KeyFn key_of, ProbeFn probe) {
+    size_t passed = 0;
+    if (batch <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            if (filter.may_contain(key_of(rows[i]))) {
+                ++passed;
+                probe(rows[i]);
+            }
+        }
+        return passed;
+    }
+    std::vector<const Row*> survivors(batch);
+    for (size_t start = 0; start < count; start += batch) {
+        size_t stop = std::min(count, start + batch);
+        for (size_t i = start; i < stop; ++i) {
+            filter.prefetch(key_of(rows[i]));
+        }
+        size_t num_survivors = 0;
+        for (size_t i = start; i < stop; ++i) {
+            if (filter.may_contain(key_of(rows[i]))) {
+                survivors[num_survivors++] = &rows[i];
+                table.prefetch(key_of(rows[i]));
+            }
+        }
+        for (size_t i = 0; i < num_survivors; ++i) {
+            prefetch_matches(table, key_of(*survivors[i]));
+        }
+        for (size_t i = 0; i < num_survivors; ++i) {
+            probe(*survivors[i]);
+        }
+        passed += num_survivors;
+    }
+    return passed;
+}
+
+#endif // BATCHED_PROBE_H
@@ -9,6 +9,8 @@ CPP_SOURCE_FILE="combined_int_long.cpp"
 CPP_EXECUTABLE="a.out"
 PYTHON_GENERATOR="data_gen.py"
 OUTPUT_FILE="run_times_and_speedups.txt"
+LOAD_THREADS=$(nproc) # Parser threads used to load A.txt and B.txt
+LLC_MB=8 # Last-level cache for --auto-plan; cost_model.h's constants were fitted with 8 MB
 
 # Arrays for test parameters
 # SIZES=(1000 10000 100000 1000000 10000000 100000000)
@@ -24,7 +26,7 @@ echo "Benchmark log started on $(date)" > "$OUTPUT_FILE"
 
 # Compile the C++ code once before starting the tests
 echo "Compiling C++ source file: $CPP_SOURCE_FILE..."
-g++ -std=c++17 -O2 "$CPP_SOURCE_FILE" -o "$CPP_EXECUTABLE"
+g++ -std=c++17 -O2 -march=native -pthread "$CPP_SOURCE_FILE" -o "$CPP_EXECUTABLE"
 if [ $? -ne 0 ]; then
     echo "Compilation failed. Exiting."
     exit 1
@@ -55,7 +57,7 @@ for size in "${SIZES[@]}"; do
         
         # Run the compiled C++ program and append its output to the log file
         echo "Running C++ benchmark..."
-        ./"$CPP_EXECUTABLE" >> "$OUTPUT_FILE"
+        ./"$CPP_EXECUTABLE" --threads="$LOAD_THREADS" --sort-merge --auto-plan --llc-mb="$LLC_MB" >> "$OUTPUT_FILE"
         
         echo "Test completed."
 
@@ -66,5 +68,5 @@ echo "------------------------------------------------------------" | tee -a "$O
 echo "All benchmarks finished. Results are in $OUTPUT_FILE"
 
 # Clean up generated files
-# rm -f A.txt B.txt As.txt Bs.txt
+# rm -f A.txt B.txt As.txt Bs.txt Cs.txt
 
@@ -0,0 +1,294 @@
+#ifndef BITPACK_H
+#define BITPACK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// -- Lightweight compression for int32 columns --
+//
+// A packed column is a sequence of blocks of up to kBlockValues values. Each block
+// picks the cheaper of two codecs:
+//   * frame-of-reference: value = base + packed
+//   * delta:              value = previous + min_delta + packed (previous starts at base)
+// and bit-packs the non-negative residuals with the smallest sufficient bit width.
+// Residuals are stored in a vertical 4-lane layout (value 4*j + lane lives in 32-bit
+// lane `lane` of the packed words), so one 128-bit shift/mask decodes four
+// consecutive values and delta decoding becomes an in-register prefix sum.
+
+constexpr size_t kPackValues = 128;   // Values per pack: 4 lanes x 32 values
+constexpr size_t kBlockValues = 1024; // Values per block (8 packs)
+
+enum class BlockCodec : uint8_t {
+    FrameOfReference = 0,
+    Delta = 1,
+};
+
+struct BlockHeader {
+    uint8_t codec;     // BlockCodec
+    uint8_t bit_width; // 0..32 bits per residual
+    uint16_t num_packs;
+    int32_t base;
+    int32_t min_delta;
+};
+static_assert(sizeof(BlockHeader) == 12, "BlockHeader is part of the on-disk format");
+
+inline uint32_t bits_needed(uint64_t range) {
+    uint32_t bits = 0;
+    while (bits < 64 && (range >> bits) != 0) {
+        ++bits;
+    }
+    return bits;
+}
+
+inline uint32_t low_bits_mask(uint32_t bit_width) {
+    return bit_width >= 32 ? 0xFFFFFFFFu : (1u << bit_width) - 1;
+}
+
+/**
+ * @brief Bit-packs 128 residuals into bit_width 128-bit words (vertical layout).
+ */
+inline void pack128(const uint32_t* in, uint32_t bit_width, uint32_t* out) {
+    std::memset(out, 0, bit_width * 16);
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        uint32_t bit = 0;
+        for (uint32_t j = 0; j < 32; ++j, bit += bit_width) {
+            uint32_t x = in[j * 4 + lane];
+            uint32_t word = bit / 32;
+            uint32_t offset = bit % 32;
+            out[word * 4 + lane] |= x << offset;
+            if (offset + bit_width > 32) {
+                out[(word + 1) * 4 + lane] |= x >> (32 - offset);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Unpacks 128 residuals written by pack128.
+ */
+inline void unpack128(const uint32_t* in, uint32_t bit_width, uint32_t* out) {
+    if (bit_width == 0) {
+        std::memset(out, 0, kPackValues * sizeof(uint32_t));
+        return;
+    }
+#if defined(__SSE2__)
+    const __m128i* words = reinterpret_cast<const __m128i*>(in);
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(low_bits_mask(bit_width)));
+    __m128i current = _mm_loadu_si128(words);
+    uint32_t word = 0;
+    uint32_t offset = 0;
+    for (uint32_t j = 0; j < 32; ++j) {
+        __m128i v = _mm_srl_epi32(current, _mm_cvtsi32_si128(static_cast<int>(offset)));
+        if (offset + bit_width > 32) {
+            __m128i next = _mm_loadu_si128(words + word + 1);
+            v = _mm_or_si128(v, _mm_sll_epi32(next, _mm_cvtsi32_si128(static_cast<int>(32 - offset))));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j * 4), _mm_and_si128(v, mask));
+        offset += bit_width;
+        if (offset >= 32) {
+            offset -= 32;
+            if (++word < bit_width) {
+                current = _mm_loadu_si128(words + word);
+            }
+        }
+    }
+#else
+    const uint32_t mask = low_bits_mask(bit_width);
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        uint32_t bit = 0;
+        for (uint32_t j = 0; j < 32; ++j, bit += bit_width) {
+            uint32_t word = bit / 32;
+            uint32_t offset = bit % 32;
+            uint64_t v = in[word * 4 + lane] >> offset;
+            if (offset + bit_width > 32) {
+                v |= static_cast<uint64_t>(in[(word + 1) * 4 + lane]) << (32 - offset);
+            }
+            out[j * 4 + lane] = static_cast<uint32_t>(v) & mask;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Turns unpacked residuals back into values (in place).
+ * @param values kPackValues residuals; receives the decoded values.
+ * @param header The block header.
+ * @param previous Last decoded value of the block so far (delta codec); updated.
+ */
+inline void apply_codec(uint32_t* values, const BlockHeader& header, uint32_t& previous) {
+#if defined(__SSE2__)
+    if (header.codec == static_cast<uint8_t>(BlockCodec::FrameOfReference)) {
+        const __m128i base = _mm_set1_epi32(header.base);
+        for (size_t j = 0; j < kPackValues; j += 4) {
+            __m128i* p = reinterpret_cast<__m128i*>(values + j);
+            _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), base));
+        }
+    } else {
+        const __m128i min_delta = _mm_set1_epi32(header.min_delta);
+        __m128i carry = _mm_set1_epi32(static_cast<int>(previous));
+        for (size_t j = 0; j < kPackValues; j += 4) {
+            __m128i* p = reinterpret_cast<__m128i*>(values + j);
+            __m128i v = _mm_add_epi32(_mm_loadu_si128(p), min_delta);
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            _mm_storeu_si128(p, v);
+            carry = _mm_shuffle_epi32(v, 0xFF);
+        }
+        previous = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+    }
+#else
+    if (header.codec == static_cast<uint8_t>(BlockCodec::FrameOfReference)) {
+        for (size_t j = 0; j < kPackValues; ++j) {
+            values[j] += static_cast<uint32_t>(header.base);
+        }
+    } else {
+        for (size_t j = 0; j < kPackValues; ++j) {
+            previous += static_cast<uint32_t>(header.min_delta) + values[j];
+            values[j] = previous;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Compresses an int32 column.
+ * @param values The column values.
+ * @param n Number of values.
+ * @return The packed byte stream.
+ */
+inline std::vector<uint8_t> encode_packed_column(const int32_t* values, size_t n) {
+    std::vector<uint8_t> stream;
+    uint32_t residuals[kBlockValues];
+    uint32_t packed[kPackValues];
+    for (size_t start = 0; start < n; start += kBlockValues) {
+        size_t count = (n - start < kBlockValues) ? n - start : kBlockValues;
+        const int32_t* v = values + start;
+
+        int64_t min_value = v[0], max_value = v[0];
+        int64_t min_delta = 0, max_delta = 0; // The first delta (v[0] - base) is 0
+        for (size_t i = 1; i < count; ++i) {
+            min_value = (v[i] < min_value) ? v[i] : min_value;
+            max_value = (v[i] > max_value) ? v[i] : max_value;
+            int64_t d = static_cast<int64_t>(v[i]) - v[i - 1];
+            min_delta = (d < min_delta) ? d : min_delta;
+            max_delta = (d > max_delta) ? d : max_delta;
+        }
+        uint32_t for_bits = bits_needed(static_cast<uint64_t>(max_value - min_value));
+        uint32_t delta_bits = bits_needed(static_cast<uint64_t>(max_delta - min_delta));
+
+        BlockHeader header;
+        header.num_packs = static_cast<uint16_t>((count + kPackValues - 1) / kPackValues);
+        if (delta_bits < for_bits) {
+            header.codec = static_cast<uint8_t>(BlockCodec::Delta);
+            header.bit_width = static_cast<uint8_t>(delta_bits);
+            header.base = v[0];
+            header.min_delta = static_cast<int32_t>(min_delta);
+            uint32_t previous = static_cast<uint32_t>(v[0]);
+            for (size_t i = 0; i < count; ++i) {
+                residuals[i] = static_cast<uint32_t>(v[i]) - previous - static_cast<uint32_t>(min_delta);
+                previous = static_cast<uint32_t>(v[i]);
+            }
+        } else {
+            header.codec = static_cast<uint8_t>(BlockCodec::FrameOfReference);
+            header.bit_width = static_cast<uint8_t>(for_bits);
+            header.base = static_cast<int32_t>(min_value);
+            header.min_delta = 0;
+            for (size_t i = 0; i < count; ++i) {
+                residuals[i] = static_cast<uint32_t>(v[i]) - static_cast<uint32_t>(min_value);
+            }
+        }
+        // Zero residuals pad the last pack; the decoder drops them.
+        std::fill(residuals + count, residuals + header.num_packs * kPackValues, 0u);
+
+        size_t offset = stream.size();
+        stream.resize(offset + sizeof(header) + header.num_packs * header.bit_width * 16);
+        std::memcpy(stream.data() + offset, &header, sizeof(header));
+        offset += sizeof(header);
+        for (size_t p = 0; p < header.num_packs; ++p) {
+            pack128(residuals + p * kPackValues, header.bit_width, packed);
+            std::memcpy(stream.data() + offset, packed, header.bit_width * 16);
+            offset += header.bit_width * 16;
+        }
+    }
+    return stream;
+}
+
+/**
+ * @brief Decodes a packed column block by block.
+ * @param data Start of the packed stream.
+ * @param bytes Size of the packed stream (or of the memory available for it).
+ * @param n Number of values in the column.
+ * @param emit Callable (const int32_t* values, size_t count, size_t row) for every block.
+ * @param consumed Optional; receives the number of stream bytes used.
+ * @return false if the stream is truncated or malformed.
+ */
+template <typename Emit>
+bool for_each_packed_block(const uint8_t* data, size_t bytes, size_t n, Emit emit, size_t* consumed = nullptr) {
+    alignas(16) uint32_t values[kBlockValues];
+    size_t offset = 0;
+    for (size_t row = 0; row < n; row += kBlockValues) {
+        size_t count = (n - row < kBlockValues) ? n - row : kBlockValues;
+        BlockHeader header;
+        if (bytes - offset < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data + offset, sizeof(header));
+        offset += sizeof(header);
+        size_t payload = static_cast<size_t>(header.num_packs) * header.bit_width * 16;
+        if (header.bit_width > 32 || header.codec > static_cast<uint8_t>(BlockCodec::Delta) ||
+            header.num_packs != (count + kPackValues - 1) / kPackValues || bytes - offset < payload) {
+            return false;
+        }
+        uint32_t previous = static_cast<uint32_t>(header.base);
+        for (size_t p = 0; p < header.num_packs; ++p) {
+            uint32_t* out = values + p * kPackValues;
+            unpack128(reinterpret_cast<const uint32_t*>(data + offset), header.bit_width, out);
+            apply_codec(out, header, previous);
+            offset += header.bit_width * 16;
+        }
+        emit(reinterpret_cast<const int32_t*>(values), count, row);
+    }
+    if (consumed != nullptr) {
+        *consumed = offset;
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the length of a packed stream by walking its block headers (no decoding).
+ * @param data Start of the packed stream.
+ * @param bytes Memory available for the stream.
+ * @param n Number of values in the column.
+ * @param size Receives the stream length in bytes.
+ * @return false if the stream is truncated or malformed.
+ */
+inline bool packed_stream_size(const uint8_t* data, size_t bytes, size_t n, size_t& size) {
+    size_t offset = 0;
+    for (size_t row = 0; row < n; row += kBlockValues) {
+        size_t count = (n - row < kBlockValues) ? n - row : kBlockValues;
+        BlockHeader header;
+        if (bytes - offset < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data + offset, sizeof(header));
+        offset += sizeof(header);
+        size_t payload = static_cast<size_t>(header.num_packs) * header.bit_width * 16;
+        if (header.bit_width > 32 || header.codec > static_cast<uint8_t>(BlockCodec::Delta) ||
+            header.num_packs != (count + kPackValues - 1) / kPackValues || bytes - offset < payload) {
+            return false;
+        }
+        offset += payload;
+    }
+    size = offset;
+    return true;
+}
+
+#endif // BITPACK_H
@@ -0,0 +1,210 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bitpack.h"
+#include "fast_io.h"
+
+// -- Binary columnar table format --
+//
+// Layout: a fixed-size ColumnFileHeader followed by one contiguous array per
+// column. Every array starts at a 64-byte aligned file offset, so a mapped
+// file can be read as `const int32_t*` / `const int64_t*` without copying.
+// PackedInt32 columns instead hold a bit-packed stream (see bitpack.h) that is
+// decoded block by block while loading.
+
+enum class ColumnType : uint32_t {
+    Int32 = 1,
+    Int64 = 2,
+    PackedInt32 = 3,
+};
+
+// Size of one uncompressed value of the column type.
+inline size_t column_type_size(ColumnType type) {
+    return type == ColumnType::Int64 ? 8 : 4;
+}
+
+constexpr char kColumnFileMagic[8] = {'G', 'J', 'C', 'O', 'L', '0', '1', '\0'};
+constexpr uint32_t kMaxColumns = 8;
+constexpr uint64_t kColumnAlignment = 64;
+
+struct ColumnMeta {
+    uint32_t type;   // ColumnType
+    uint32_t reserved;
+    uint64_t offset; // Byte offset of the column array from the start of the file
+};
+
+struct ColumnFileHeader {
+    char magic[8];
+    uint64_t num_rows;
+    uint32_t num_columns;
+    uint32_t reserved;
+    ColumnMeta columns[kMaxColumns];
+};
+
+/**
+ * @brief One column to be written: its type and a pointer to num_rows values
+ * (int32 values for PackedInt32; they are compressed on write).
+ */
+struct ColumnData {
+    ColumnType type;
+    const void* data;
+};
+
+/**
+ * @brief Writes a columnar table file.
+ * @param filename The name of the output file.
+ * @param num_rows Number of rows in every column.
+ * @param columns The columns, in order.
+ * @return true on success.
+ */
+inline bool write_column_file(const std::string& filename, uint64_t num_rows, const std::vector<ColumnData>& columns) {
+    if (columns.empty() || columns.size() > kMaxColumns) {
+        std::cerr << "Error: A column file holds 1 to " << kMaxColumns << " columns" << std::endl;
+        return false;
+    }
+
+    ColumnFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kColumnFileMagic, sizeof(header.magic));
+    header.num_rows = num_rows;
+    header.num_columns = static_cast<uint32_t>(columns.size());
+    std::vector<std::vector<uint8_t>> packed(columns.size());
+    std::vector<uint64_t> column_bytes(columns.size());
+    uint64_t offset = sizeof(ColumnFileHeader);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].type == ColumnType::PackedInt32) {
+            packed[i] = encode_packed_column(static_cast<const int32_t*>(columns[i].data), num_rows);
+            column_bytes[i] = packed[i].size();
+        } else {
+            column_bytes[i] = num_rows * column_type_size(columns[i].type);
+        }
+        offset = (offset + kColumnAlignment - 1) / kColumnAlignment * kColumnAlignment;
+        header.columns[i].type = static_cast<uint32_t>(columns[i].type);
+        header.columns[i].offset = offset;
+        offset += column_bytes[i];
+    }
+
+    std::ofstream output_file(filename, std::ios::binary);
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
+        return false;
+    }
+    output_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    const char padding[kColumnAlignment] = {};
+    for (size_t i = 0; i < columns.size(); ++i) {
+        output_file.write(padding, static_cast<std::streamsize>(header.columns[i].offset - written));
+        const void* data = packed[i].empty() ? columns[i].data : packed[i].data();
+        output_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(column_bytes[i]));
+        written = header.columns[i].offset + column_bytes[i];
+    }
+    output_file.close();
+    if (!output_file) {
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief A memory-mapped columnar table file; column arrays point straight into the mapping.
+ */
+class ColumnFile {
+public:
+    /**
+     * @brief Maps and validates a column file.
+     * @param filename The name of the file to open.
+     * @return true if the file exists and has a valid header.
+     */
+    bool open(const std::string& filename) {
+        if (!file_.open(filename)) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        if (file_.size() < sizeof(ColumnFileHeader)) {
+            std::cerr << "Error: " << filename << " is not a column file" << std::endl;
+            return false;
+        }
+        header_ = reinterpret_cast<const ColumnFileHeader*>(file_.data());
+        if (std::memcmp(header_->magic, kColumnFileMagic, sizeof(kColumnFileMagic)) != 0 ||
+            header_->num_columns == 0 || header_->num_columns > kMaxColumns) {
+            std::cerr << "Error: " << filename << " is not a column file" << std::endl;
+            return false;
+        }
+        for (uint32_t i = 0; i < header_->num_columns; ++i) {
+            const ColumnMeta& meta = header_->columns[i];
+            bool valid_type = meta.type >= static_cast<uint32_t>(ColumnType::Int32) &&
+                              meta.type <= static_cast<uint32_t>(ColumnType::PackedInt32);
+            uint64_t bytes = 0;
+            if (valid_type && meta.offset <= file_.size()) {
+                bytes = header_->num_rows * column_type_size(static_cast<ColumnType>(meta.type));
+                if (meta.type == static_cast<uint32_t>(ColumnType::PackedInt32)) {
+                    size_t stream_bytes = 0;
+                    valid_type = packed_stream_size(reinterpret_cast<const uint8_t*>(file_.data() + meta.offset),
+                                                    file_.size() - meta.offset, header_->num_rows, stream_bytes);
+                    bytes = stream_bytes;
+                }
+            }
+            if (!valid_type || meta.offset % kColumnAlignment != 0 || meta.offset + bytes > file_.size()) {
+                std::cerr << "Error: " << filename << " is truncated or corrupt" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t num_rows() const { return header_->num_rows; }
+    uint32_t num_columns() const { return header_->num_columns; }
+    size_t size_bytes() const { return file_.size(); }
+
+    ColumnType type(uint32_t i) const {
+        return static_cast<ColumnType>(header_->columns[i].type);
+    }
+
+    /**
+     * @brief Returns the i-th column as an array of T.
+     * @return nullptr if the column does not exist or does not hold T.
+     */
+    template <typename T>
+    const T* column(uint32_t i) const {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "columns hold 32- or 64-bit integers");
+        if (i >= header_->num_columns || type(i) == ColumnType::PackedInt32 || column_type_size(type(i)) != sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(file_.data() + header_->columns[i].offset);
+    }
+
+    /**
+     * @brief Calls emit(const int32_t* values, size_t count, size_t row) over an int32 column,
+     * decompressing PackedInt32 columns block by block; plain Int32 columns are passed in one call.
+     * @return false if the column is not an int32 column.
+     */
+    template <typename Emit>
+    bool for_each_int32_block(uint32_t i, Emit emit) const {
+        if (i >= header_->num_columns) {
+            return false;
+        }
+        if (type(i) == ColumnType::Int32) {
+            emit(column<int32_t>(i), static_cast<size_t>(header_->num_rows), size_t(0));
+            return true;
+        }
+        if (type(i) == ColumnType::PackedInt32) {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(file_.data() + header_->columns[i].offset);
+            return for_each_packed_block(data, file_.size() - header_->columns[i].offset, header_->num_rows, emit);
+        }
+        return false;
+    }
+
+private:
+    MappedFile file_;
+    const ColumnFileHeader* header_ = nullptr;
+};
+
+#endif // COLUMN_STORE_H
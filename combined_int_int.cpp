@@ -1,12 +1,30 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <cstring>
 #include <chrono>
+#include <mutex>
+#include <random>
+#include <cstdlib>
 #include <algorithm> // Required for std::sort
 
+#include "batched_probe.h"
+#include "bloom_filter.h"
+#include "column_store.h"
+#include "cost_model.h"
+#include "csr_hash_table.h"
+#include "csv_scan.h"
+#include "dense_array_map.h"
+#include "fast_io.h"
+#include "flat_hash_map.h"
+#include "grace_join.h"
+#include "hyperloglog.h"
+#include "radix_partition.h"
+#include "radix_sort.h"
+#include "swiss_hash_map.h"
+#include "table_schema.h"
+
 // -- Data Structures to represent table rows --
 
 // Represents a single row from table A
@@ -28,196 +46,725 @@ struct JoinedRow {
     int b_k;
 };
 
+// Key and original row index of an A row, partitioned by radix_hash_join_row_ids
+struct KeyRowId {
+    int k;
+    uint32_t row;
+};
+
 // Represents a final aggregated result row
 struct AggregatedResult {
     int k;
     long long sum_v; // Use long long to handle potentially large sums
 };
 
-// -- Helper Functions --
+// Aggregate slot of one A group in the GroupJoin hash table
+struct GroupJoinSlot {
+    long long sum_v;   // SUM(A.v) over the group
+    int match_count;   // Number of B rows with the group's key
+};
+
+// Text layouts of A.txt (k,v) and B.txt (k)
+using SchemaA = TableSchema<RowA, 2, ',', Column<0, &RowA::k>, Column<1, &RowA::v>>;
+using SchemaB = TableSchema<RowB, 1, ',', Column<0, &RowB::k>>;
+
+// -- Core Logic Functions --
 
 /**
- * @brief Parses a CSV string and returns a vector of strings.
- * @param line The string line to parse.
- * @param delimiter The character to split the string by.
- * @return A vector of string tokens.
+ * @brief Returns an empty table reserved for expected_keys keys, so it does not rehash while it fills.
  */
-std::vector<std::string> parse_csv_line(const std::string& line, char delimiter = ',') {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(line);
-    while (std::getline(tokenStream, token, delimiter)) {
-        // Trim leading/trailing whitespace
-        size_t first = token.find_first_not_of(" \t\n\r");
-        if (std::string::npos == first) {
-            tokens.push_back("");
-            continue;
-        }
-        size_t last = token.find_last_not_of(" \t\n\r");
-        tokens.push_back(token.substr(first, (last - first + 1)));
-    }
-    return tokens;
+template <typename Table>
+Table presized(size_t expected_keys) {
+    Table table;
+    table.reserve(expected_keys);
+    return table;
 }
 
+// --- METHOD 1: Post-Aggregation (Hash Join then Aggregate) ---
 
-// -- Core Logic Functions --
+/**
+ * @brief Parses the (k,v) rows of table A found in [p, end).
+ * @param p Start of the byte range; must be at the beginning of a line.
+ * @param end End of the byte range.
+ * @param filename The name of the source file, for error messages.
+ * @param table Receives the parsed rows.
+ * @param key_domain Widened to cover every parsed key.
+ * @param key_sketch Receives every parsed key.
+ */
+void parse_rows_a(const char* p, const char* end, const std::string& filename, std::vector<RowA>& table, KeyDomain& key_domain,
+                  HyperLogLog& key_sketch) {
+    scan_table<SchemaA>(p, end,
+        [&](const RowA& row) {
+            table.push_back(row);
+            key_domain.add(row.k);
+            key_sketch.add(row.k);
+        },
+        [&](Field line) {
+            std::cerr << "Invalid row in file " << filename << " on line: " << std::string(line.begin, line.end) << '\n';
+        });
+}
 
-// --- METHOD 1: Post-Aggregation (Hash Join then Aggregate) ---
+/**
+ * @brief Parses the (k) rows of table B found in [p, end).
+ * @param p Start of the byte range; must be at the beginning of a line.
+ * @param end End of the byte range.
+ * @param filename The name of the source file, for error messages.
+ * @param table Receives the parsed rows.
+ * @param key_sketch Receives every parsed key.
+ */
+void parse_rows_b(const char* p, const char* end, const std::string& filename, std::vector<RowB>& table, HyperLogLog& key_sketch) {
+    scan_table<SchemaB>(p, end,
+        [&](const RowB& row) {
+            table.push_back(row);
+            key_sketch.add(row.k);
+        },
+        [&](Field line) {
+            std::cerr << "Invalid row in file " << filename << " on line: " << std::string(line.begin, line.end) << '\n';
+        });
+}
 
 /**
  * @brief Reads data from a CSV file into a vector of RowA structs.
+ * By default the file is memory-mapped and parsed in place, split into newline-aligned
+ * chunks that are parsed concurrently. With options.async_io it is instead read through
+ * an AsyncFileReader that keeps options.io_depth buffers in flight ahead of the parser.
  * @param filename The name of the file to read.
+ * @param stats Optional; receives the bytes parsed and the load time.
+ * @param options How to read the file.
+ * @param key_domain Optional; receives the range of the keys k.
+ * @param key_sketch Optional; receives a HyperLogLog sketch of the keys k.
  * @return A vector of RowA structs.
  */
-std::vector<RowA> read_table_a(const std::string& filename) {
+std::vector<RowA> read_table_a(const std::string& filename, LoadStats* stats = nullptr, const LoadOptions& options = LoadOptions(),
+                               KeyDomain* key_domain = nullptr, HyperLogLog* key_sketch = nullptr) {
+    auto start = std::chrono::high_resolution_clock::now();
     std::vector<RowA> table;
-    std::ifstream file(filename);
-    std::string line;
-
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        return table;
-    }
-
-    while (std::getline(file, line)) {
-        std::vector<std::string> tokens = parse_csv_line(line);
-        if (tokens.size() == 2) {
-            try {
-                RowA row;
-                row.k = std::stoi(tokens[0]);
-                row.v = std::stoi(tokens[1]);
-                table.push_back(row);
-            } catch (const std::invalid_argument& ia) {
-                std::cerr << "Invalid argument in file " << filename << ": " << ia.what() << " on line: " << line << '\n';
-            }
+    size_t bytes = 0;
+    KeyDomain keys;
+    HyperLogLog sketch;
+
+    if (options.async_io) {
+        bool ok = for_each_line_chunk(filename, options.buffer_size,
+            [&](const char* begin, const char* end) { parse_rows_a(begin, end, filename, table, keys, sketch); }, &bytes, options.io_depth);
+        if (!ok) {
+            std::cerr << "Error: Could not read file " << filename << std::endl;
+            return {};
         }
+    } else {
+        MappedFile file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return {};
+        }
+        // Each chunk tracks its own key range and sketch and merges them once it is parsed.
+        std::mutex keys_mutex;
+        table = parallel_parse<RowA>(file.data(), file.size(), options.num_threads,
+            [&](const char* begin, const char* end, std::vector<RowA>& out) {
+                KeyDomain chunk_keys;
+                HyperLogLog chunk_sketch;
+                parse_rows_a(begin, end, filename, out, chunk_keys, chunk_sketch);
+                std::lock_guard<std::mutex> lock(keys_mutex);
+                keys.merge(chunk_keys);
+                sketch.merge(chunk_sketch);
+            });
+        bytes = file.size();
+    }
+
+    if (stats != nullptr) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        stats->bytes = bytes;
+        stats->millis = elapsed.count();
+    }
+    if (key_domain != nullptr) {
+        *key_domain = keys;
+    }
+    if (key_sketch != nullptr) {
+        *key_sketch = sketch;
     }
-    file.close();
     return table;
 }
 
 /**
  * @brief Reads data from a CSV file into a vector of RowB structs.
+ * By default the file is memory-mapped and parsed in place, split into newline-aligned
+ * chunks that are parsed concurrently. With options.async_io it is instead read through
+ * an AsyncFileReader that keeps options.io_depth buffers in flight ahead of the parser.
  * @param filename The name of the file to read.
+ * @param stats Optional; receives the bytes parsed and the load time.
+ * @param options How to read the file.
+ * @param key_sketch Optional; receives a HyperLogLog sketch of the keys k.
  * @return A vector of RowB structs.
  */
-std::vector<RowB> read_table_b(const std::string& filename) {
+std::vector<RowB> read_table_b(const std::string& filename, LoadStats* stats = nullptr, const LoadOptions& options = LoadOptions(),
+                               HyperLogLog* key_sketch = nullptr) {
+    auto start = std::chrono::high_resolution_clock::now();
     std::vector<RowB> table;
-    std::ifstream file(filename);
-    std::string line;
-
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        return table;
-    }
-
-    while (std::getline(file, line)) {
-        std::vector<std::string> tokens = parse_csv_line(line);
-        if (tokens.size() == 1) {
-             try {
-                RowB row;
-                row.k = std::stoi(tokens[0]);
-                table.push_back(row);
-            } catch (const std::invalid_argument& ia) {
-                std::cerr << "Invalid argument in file " << filename << ": " << ia.what() << " on line: " << line << '\n';
-            }
+    size_t bytes = 0;
+    HyperLogLog sketch;
+
+    if (options.async_io) {
+        bool ok = for_each_line_chunk(filename, options.buffer_size,
+            [&](const char* begin, const char* end) { parse_rows_b(begin, end, filename, table, sketch); }, &bytes, options.io_depth);
+        if (!ok) {
+            std::cerr << "Error: Could not read file " << filename << std::endl;
+            return {};
         }
+    } else {
+        MappedFile file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return {};
+        }
+        std::mutex sketch_mutex;
+        table = parallel_parse<RowB>(file.data(), file.size(), options.num_threads,
+            [&](const char* begin, const char* end, std::vector<RowB>& out) {
+                HyperLogLog chunk_sketch;
+                parse_rows_b(begin, end, filename, out, chunk_sketch);
+                std::lock_guard<std::mutex> lock(sketch_mutex);
+                sketch.merge(chunk_sketch);
+            });
+        bytes = file.size();
+    }
+
+    if (stats != nullptr) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        stats->bytes = bytes;
+        stats->millis = elapsed.count();
+    }
+    if (key_sketch != nullptr) {
+        *key_sketch = sketch;
+    }
+    return table;
+}
+
+/**
+ * @brief Loads table A from a columnar file written by csv_to_columnar (columns: k, v as i32 or p32).
+ * The file is memory-mapped; rows are assembled straight from the mapped column arrays,
+ * decoding bit-packed columns block by block.
+ * @param filename The name of the column file.
+ * @param stats Optional; receives the bytes read and the load time.
+ * @param key_domain Optional; receives the range of the keys k.
+ * @param key_sketch Optional; receives a HyperLogLog sketch of the keys k.
+ * @return A vector of RowA structs.
+ */
+std::vector<RowA> read_table_a_columnar(const std::string& filename, LoadStats* stats = nullptr, KeyDomain* key_domain = nullptr,
+                                        HyperLogLog* key_sketch = nullptr) {
+    auto start = std::chrono::high_resolution_clock::now();
+    ColumnFile file;
+    if (!file.open(filename)) {
+        return {};
+    }
+    std::vector<RowA> table(file.num_rows());
+    KeyDomain keys;
+    HyperLogLog sketch;
+    bool ok = file.num_columns() == 2;
+    ok = ok && file.for_each_int32_block(0, [&](const int32_t* k, size_t count, size_t row) {
+        for (size_t i = 0; i < count; ++i) {
+            table[row + i].k = k[i];
+            keys.add(k[i]);
+            sketch.add(k[i]);
+        }
+    });
+    ok = ok && file.for_each_int32_block(1, [&](const int32_t* v, size_t count, size_t row) {
+        for (size_t i = 0; i < count; ++i) {
+            table[row + i].v = v[i];
+        }
+    });
+    if (!ok) {
+        std::cerr << "Error: " << filename << " must hold two int32 columns (k, v)" << std::endl;
+        return {};
+    }
+
+    if (stats != nullptr) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        stats->bytes = file.size_bytes();
+        stats->millis = elapsed.count();
+    }
+    if (key_domain != nullptr) {
+        *key_domain = keys;
+    }
+    if (key_sketch != nullptr) {
+        *key_sketch = sketch;
+    }
+    return table;
+}
+
+/**
+ * @brief Loads table B from a columnar file written by csv_to_columnar (column: k as i32 or p32).
+ * @param filename The name of the column file.
+ * @param stats Optional; receives the bytes read and the load time.
+ * @param key_sketch Optional; receives a HyperLogLog sketch of the keys k.
+ * @return A vector of RowB structs.
+ */
+std::vector<RowB> read_table_b_columnar(const std::string& filename, LoadStats* stats = nullptr, HyperLogLog* key_sketch = nullptr) {
+    static_assert(sizeof(RowB) == sizeof(int32_t), "RowB must match the layout of an i32 column");
+    auto start = std::chrono::high_resolution_clock::now();
+    ColumnFile file;
+    if (!file.open(filename)) {
+        return {};
+    }
+    std::vector<RowB> table(file.num_rows());
+    HyperLogLog sketch;
+    bool ok = file.num_columns() == 1 && file.for_each_int32_block(0, [&](const int32_t* k, size_t count, size_t row) {
+        std::memcpy(table.data() + row, k, count * sizeof(RowB));
+        for (size_t i = 0; i < count; ++i) {
+            sketch.add(k[i]);
+        }
+    });
+    if (!ok) {
+        std::cerr << "Error: " << filename << " must hold one int32 column (k)" << std::endl;
+        return {};
+    }
+
+    if (stats != nullptr) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        stats->bytes = file.size_bytes();
+        stats->millis = elapsed.count();
+    }
+    if (key_sketch != nullptr) {
+        *key_sketch = sketch;
     }
-    file.close();
     return table;
 }
 
+/**
+ * @brief Builds a hash table over A and probes it with every B row, calling emit(row_b, payload)
+ * for each match; hash_join and hash_join_row_ids differ only in the payload and what they emit.
+ * @param payload_of Callable (const RowA&) -> the JoinTable's payload.
+ * @param emit Callable (const RowB&, payload).
+ * @param stats_name Name of the table in its TABLE_STATS line.
+ * @see hash_join for the other parameters.
+ */
+template <typename JoinTable, typename PayloadFn, typename EmitFn>
+void hash_join_matches(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b, PayloadFn payload_of, EmitFn emit,
+                       size_t probe_batch, BloomFilterStats* bloom_stats, size_t expected_keys, [[maybe_unused]] const char* stats_name) {
+    JoinTable hash_table = presized<JoinTable>(expected_keys);
+    hash_table.build(table_a.data(), table_a.size(), [](const RowA& row) { return row.k; }, payload_of);
+    // The filter holds one entry per distinct key of A; without an estimate, one per row.
+    BlockedBloomFilter filter(bloom_stats == nullptr ? 0 : expected_keys != 0 ? expected_keys : table_a.size());
+    if (bloom_stats != nullptr) {
+        for (const auto& row_a : table_a) {
+            filter.insert(row_a.k);
+        }
+    }
+
+    auto probe = [&](const RowB& row_b) {
+        hash_table.for_each_match(row_b.k, [&](const auto& payload) {
+            emit(row_b, payload);
+        });
+    };
+    auto key_of = [](const RowB& row) { return row.k; };
+    if (bloom_stats == nullptr) {
+        probe_batched(hash_table, table_b.data(), table_b.size(), probe_batch, key_of, probe);
+    } else {
+        // Check each batch against the filter; only keys that pass are prefetched and probed.
+        bloom_stats->probes += table_b.size();
+        bloom_stats->passed += probe_batched_filtered(filter, hash_table, table_b.data(), table_b.size(), probe_batch, key_of, probe);
+    }
+    TABLE_STATS(hash_table.stats().print(stats_name);)
+}
+
 /**
  * @brief Performs a hash join on two tables.
+ * The build side is stored in a CsrHashTable, so all A rows of a key are adjacent in memory.
+ * B is probed in batches whose buckets are prefetched before they are resolved.
+ * @tparam JoinTable CsrHashTable<int> or SwissJoinTable<int>.
  * @param table_a The left table (build side).
  * @param table_b The right table (probe side).
+ * @param probe_batch Probe keys prefetched at a time; 1 disables prefetching.
+ * @param bloom_stats Optional; if given, A's keys are also put in a Bloom filter (sized by
+ *        expected_keys, or by A's row count when that is 0) that every B key must pass before
+ *        probing the table, and the filter's pass counts are added here.
+ * @param expected_keys Estimated distinct keys of A, used to size the table; 0 sizes it by A's rows.
  * @return A vector of JoinedRow structs representing the result of the join.
  */
-std::vector<JoinedRow> hash_join(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b) {
-    std::unordered_map<int, std::vector<const RowA*>> hash_table;
-    for (const auto& row_a : table_a) {
-        hash_table[row_a.k].push_back(&row_a);
-    }
-    
+template <typename JoinTable = CsrHashTable<int>>
+std::vector<JoinedRow> hash_join(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b,
+                                 size_t probe_batch = kDefaultProbeBatch, BloomFilterStats* bloom_stats = nullptr,
+                                 size_t expected_keys = 0) {
     std::vector<JoinedRow> joined_result;
-    for (const auto& row_b : table_b) {
-        auto it = hash_table.find(row_b.k);
-        if (it != hash_table.end()) {
-            for (const auto* matching_row_a_ptr : it->second) {
-                joined_result.push_back({matching_row_a_ptr->k, matching_row_a_ptr->v, row_b.k});
-            }
+    hash_join_matches<JoinTable>(table_a, table_b,
+        [](const RowA& row) { return row.v; },
+        [&](const RowB& row_b, int a_v) { joined_result.push_back({row_b.k, a_v, row_b.k}); },
+        probe_batch, bloom_stats, expected_keys, "hash_join");
+    return joined_result;
+}
+
+/**
+ * @brief Performs a hash join that emits the A row index of every match instead of a JoinedRow.
+ * The table's payload is the row index, and aggregate_row_ids gathers A.k and A.v afterwards
+ * (late materialization), so the join writes 4 bytes per match instead of 12. B's row index
+ * is left out: the query reads no column of B, and B.k equals A.k.
+ * @tparam JoinTable CsrHashTable<uint32_t> or SwissJoinTable<uint32_t>.
+ * @see hash_join for the parameters; A must have fewer than 2^32 rows.
+ * @return The A row index of every match, in probe order.
+ */
+template <typename JoinTable = CsrHashTable<uint32_t>>
+std::vector<uint32_t> hash_join_row_ids(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b,
+                                        size_t probe_batch = kDefaultProbeBatch, BloomFilterStats* bloom_stats = nullptr,
+                                        size_t expected_keys = 0) {
+    const RowA* rows_a = table_a.data();
+    std::vector<uint32_t> a_rows;
+    hash_join_matches<JoinTable>(table_a, table_b,
+        [rows_a](const RowA& row) { return static_cast<uint32_t>(&row - rows_a); },
+        [&](const RowB&, uint32_t a_row) { a_rows.push_back(a_row); },
+        probe_batch, bloom_stats, expected_keys, "hash_join_row_ids");
+    return a_rows;
+}
+
+/**
+ * @brief Radix-partitions A's rows and B, joins each pair of partitions with its own hash table,
+ * and calls emit(row_b, payload) for each match.
+ * @param rows_a, count_a The build rows, RowA or KeyRowId.
+ * @param payload_of Callable (const RowP&) -> the JoinTable's payload.
+ * @param emit Callable (const RowB&, payload).
+ * @see radix_hash_join for the other parameters.
+ */
+template <typename JoinTable, typename RowP, typename PayloadFn, typename EmitFn>
+void radix_join_matches(const RowP* rows_a, size_t count_a, const std::vector<RowB>& table_b, int radix_bits,
+                        PayloadFn payload_of, EmitFn emit, size_t probe_batch) {
+    auto key_of_a = [](const RowP& row) { return row.k; };
+    auto key_of_b = [](const RowB& row) { return row.k; };
+    RadixPartitions<RowP> parts_a = radix_partition(rows_a, count_a, radix_bits, key_of_a);
+    RadixPartitions<RowB> parts_b = radix_partition(table_b.data(), table_b.size(), radix_bits, key_of_b);
+
+    for (size_t p = 0; p < parts_a.num_partitions(); ++p) {
+        if (parts_a.size(p) == 0 || parts_b.size(p) == 0) {
+            continue;
         }
+        JoinTable hash_table;
+        hash_table.build(parts_a.begin(p), parts_a.size(p), key_of_a, payload_of);
+        probe_batched(hash_table, parts_b.begin(p), parts_b.size(p), probe_batch, key_of_b, [&](const RowB& row_b) {
+            hash_table.for_each_match(row_b.k, [&](const auto& payload) {
+                emit(row_b, payload);
+            });
+        });
     }
+}
+
+/**
+ * @brief Performs a radix-partitioned hash join on two tables.
+ * A and B are split into 2^radix_bits partitions by the same hash bits, and each pair of
+ * partitions is joined with its own cache-sized hash table, so neither the build nor the
+ * probes touch more than one partition's table at a time.
+ * @tparam JoinTable CsrHashTable<int> or SwissJoinTable<int>.
+ * @param table_a The left table (build side).
+ * @param table_b The right table (probe side).
+ * @param radix_bits Partition bits, 1 to kMaxRadixBits (two partitioning passes above kMaxRadixBitsPerPass).
+ * @param probe_batch Probe keys prefetched at a time; 1 disables prefetching.
+ * @return A vector of JoinedRow structs representing the result of the join.
+ */
+template <typename JoinTable = CsrHashTable<int>>
+std::vector<JoinedRow> radix_hash_join(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b, int radix_bits,
+                                       size_t probe_batch = kDefaultProbeBatch) {
+    std::vector<JoinedRow> joined_result;
+    radix_join_matches<JoinTable>(table_a.data(), table_a.size(), table_b, radix_bits,
+        [](const RowA& row) { return row.v; },
+        [&](const RowB& row_b, int a_v) { joined_result.push_back({row_b.k, a_v, row_b.k}); }, probe_batch);
     return joined_result;
 }
 
+/**
+ * @brief Radix-partitioned hash_join_row_ids. A is partitioned as (k, row index) pairs, the
+ * same 8 bytes as a RowA, so the indices survive the partitioning.
+ * @tparam JoinTable CsrHashTable<uint32_t> or SwissJoinTable<uint32_t>.
+ * @see radix_hash_join for the parameters.
+ * @return The A row index of every match, in partition order.
+ */
+template <typename JoinTable = CsrHashTable<uint32_t>>
+std::vector<uint32_t> radix_hash_join_row_ids(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b, int radix_bits,
+                                              size_t probe_batch = kDefaultProbeBatch) {
+    std::vector<KeyRowId> keys_a(table_a.size());
+    for (size_t i = 0; i < table_a.size(); ++i) {
+        keys_a[i] = {table_a[i].k, static_cast<uint32_t>(i)};
+    }
+    std::vector<uint32_t> a_rows;
+    radix_join_matches<JoinTable>(keys_a.data(), keys_a.size(), table_b, radix_bits,
+        [](const KeyRowId& row) { return row.row; },
+        [&](const RowB&, uint32_t a_row) { a_rows.push_back(a_row); }, probe_batch);
+    return a_rows;
+}
+
 /**
  * @brief Performs aggregation (GROUP BY k, SUM v) on the joined data.
+ * @tparam AggregationTable FlatHashMap<int, long long> or DenseArrayMap<long long>.
  * @param joined_data The vector of JoinedRow structs.
+ * @param aggregation_map Empty table that receives the per-key sums.
  * @return A vector of AggregatedResult structs.
  */
-std::vector<AggregatedResult> perform_aggregation(const std::vector<JoinedRow>& joined_data) {
-    std::unordered_map<int, long long> aggregation_map;
+template <typename AggregationTable = FlatHashMap<int, long long>>
+std::vector<AggregatedResult> perform_aggregation(const std::vector<JoinedRow>& joined_data,
+                                                  AggregationTable aggregation_map = AggregationTable()) {
     for (const auto& row : joined_data) {
         aggregation_map[row.a_k] += row.a_v;
     }
 
     std::vector<AggregatedResult> final_result;
-    for (const auto& pair : aggregation_map) {
-        final_result.push_back({pair.first, pair.second});
+    final_result.reserve(aggregation_map.size());
+    aggregation_map.for_each([&](int k, long long sum_v) {
+        final_result.push_back({k, sum_v});
+    });
+    TABLE_STATS(aggregation_map.stats().print("perform_aggregation");)
+    return final_result;
+}
+
+/**
+ * @brief Performs the aggregation (GROUP BY k, SUM v) on a late-materialized join: A.k and A.v
+ * are gathered from A through the row indices, prefetched a batch ahead since A is read out of order.
+ * @tparam AggregationTable FlatHashMap<int, long long> or DenseArrayMap<long long>.
+ * @param a_rows The A row index of every match, from hash_join_row_ids.
+ * @param table_a The table the indices refer to.
+ * @param aggregation_map Empty table that receives the per-key sums.
+ * @return A vector of AggregatedResult structs.
+ */
+template <typename AggregationTable = FlatHashMap<int, long long>>
+std::vector<AggregatedResult> aggregate_row_ids(const std::vector<uint32_t>& a_rows, const std::vector<RowA>& table_a,
+                                                AggregationTable aggregation_map = AggregationTable()) {
+    const size_t prefetch_distance = kDefaultProbeBatch;
+    for (size_t i = 0; i < a_rows.size(); ++i) {
+        if (i + prefetch_distance < a_rows.size()) {
+            __builtin_prefetch(&table_a[a_rows[i + prefetch_distance]]);
+        }
+        const RowA& row = table_a[a_rows[i]];
+        aggregation_map[row.k] += row.v;
     }
+
+    std::vector<AggregatedResult> final_result;
+    final_result.reserve(aggregation_map.size());
+    aggregation_map.for_each([&](int k, long long sum_v) {
+        final_result.push_back({k, sum_v});
+    });
+    TABLE_STATS(aggregation_map.stats().print("aggregate_row_ids");)
     return final_result;
 }
 
 // --- METHOD 2: Pre-Aggregation (GroupJoin) ---
 
 /**
- * @brief Performs a join and aggregation using a pre-aggregation strategy on in-memory vectors.
+ * @brief Performs a join and aggregation using a GroupJoin on in-memory vectors.
+ * A single hash table over A's groups holds {sum_v, match_count}; B only probes it,
+ * so B keys without a partner in A are never inserted anywhere.
+ * @tparam GroupTable FlatHashMap, SwissHashMap or DenseArrayMap of GroupJoinSlot.
  * @param table_a The vector for the left table (A).
  * @param table_b The vector for the right table (B).
+ * @param groups Empty table that receives the groups of A.
+ * @param probe_batch B keys prefetched at a time; 1 disables prefetching.
+ * @param bloom_stats Optional; if given, B keys are checked against a Bloom filter of A's keys
+ *        before probing the groups, and the filter's pass counts are added here.
  * @return A vector of AggregatedResult structs.
  */
-std::vector<AggregatedResult> pre_aggregation_join(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b) {
-    // 1. Read table A and pre-aggregate sums of 'v' for each key 'k'.
-    std::unordered_map<int, long long> pre_agg_a;
+template <typename GroupTable = FlatHashMap<int, GroupJoinSlot>>
+std::vector<AggregatedResult> pre_aggregation_join(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b,
+                                                   GroupTable groups = GroupTable(), size_t probe_batch = kDefaultProbeBatch,
+                                                   BloomFilterStats* bloom_stats = nullptr) {
+    // 1. Build: pre-aggregate sums of 'v' for each key 'k' from table A.
     for (const auto& row : table_a) {
-        pre_agg_a[row.k] += row.v;
+        groups[row.k].sum_v += row.v;
+    }
+    // The filter holds one entry per group, so it is sized by A's distinct keys.
+    BlockedBloomFilter filter(bloom_stats != nullptr ? groups.size() : 0);
+    if (bloom_stats != nullptr) {
+        groups.for_each([&](int k, const GroupJoinSlot&) { filter.insert(k); });
     }
 
-    // 2. Read table B and count occurrences of each key 'k'.
-    std::unordered_map<int, int> key_counts_b;
-    for (const auto& row : table_b) {
-        key_counts_b[row.k]++;
+    // 2. Probe: count the B rows that match each existing group, prefetching batches of keys.
+    auto probe = [&](const RowB& row) {
+        if (GroupJoinSlot* slot = groups.find(row.k)) {
+            slot->match_count++;
+        }
+    };
+    auto key_of = [](const RowB& row) { return row.k; };
+    if (bloom_stats == nullptr) {
+        probe_batched(groups, table_b.data(), table_b.size(), probe_batch, key_of, probe);
+    } else {
+        bloom_stats->probes += table_b.size();
+        bloom_stats->passed += probe_batched_filtered(filter, groups, table_b.data(), table_b.size(), probe_batch, key_of, probe);
     }
 
-    // 3. Join the aggregated results.
+    // 3. Emit SUM(v) * matches for every group that joined.
     std::vector<AggregatedResult> final_result;
-    for(const auto& b_pair : key_counts_b) {
-        int k = b_pair.first;
-        int count_in_b = b_pair.second;
-
-        auto a_it = pre_agg_a.find(k);
-        if (a_it != pre_agg_a.end()) {
-            long long sum_in_a = a_it->second;
-            long long final_sum = sum_in_a * count_in_b;
-            final_result.push_back({k, final_sum});
+    groups.for_each([&](int k, const GroupJoinSlot& slot) {
+        if (slot.match_count > 0) {
+            final_result.push_back({k, slot.sum_v * slot.match_count});
         }
+    });
+
+    TABLE_STATS(groups.stats().print("pre_aggregation_join");)
+    return final_result;
+}
+
+/**
+ * @brief Performs the pre-aggregation join directly from the input files, without materializing the tables.
+ * Both files are read through fixed-size buffers, filled ahead of the parser on background
+ * threads, and each row is fed straight into the GroupJoin hash table, so peak memory
+ * is bounded by the number of distinct keys in A.
+ * @param file_a The filename for the left table (A).
+ * @param file_b The filename for the right table (B).
+ * @param buffer_size Size of each read buffer in bytes.
+ * @param io_depth Number of buffers kept in flight ahead of the parser.
+ * @return A vector of AggregatedResult structs.
+ */
+std::vector<AggregatedResult> streaming_pre_aggregation_join(const std::string& file_a, const std::string& file_b, size_t buffer_size, int io_depth) {
+    // 1. Build: stream table A and pre-aggregate sums of 'v' for each key 'k'.
+    FlatHashMap<int, GroupJoinSlot> groups;
+    bool ok = for_each_line_chunk(file_a, buffer_size, [&](const char* begin, const char* end) {
+        scan_table<SchemaA>(begin, end, [&](const RowA& row) { groups[row.k].sum_v += row.v; }, [](Field) {});
+    }, nullptr, io_depth);
+    if (!ok) {
+        std::cerr << "Error: Could not read file " << file_a << std::endl;
+        return {};
     }
 
+    // 2. Probe: stream table B and count the rows that match each existing group.
+    ok = for_each_line_chunk(file_b, buffer_size, [&](const char* begin, const char* end) {
+        scan_table<SchemaB>(begin, end, [&](const RowB& row) {
+            if (GroupJoinSlot* slot = groups.find(row.k)) {
+                slot->match_count++;
+            }
+        }, [](Field) {});
+    }, nullptr, io_depth);
+    if (!ok) {
+        std::cerr << "Error: Could not read file " << file_b << std::endl;
+        return {};
+    }
+
+    // 3. Emit SUM(v) * matches for every group that joined.
+    std::vector<AggregatedResult> final_result;
+    groups.for_each([&](int k, const GroupJoinSlot& slot) {
+        if (slot.match_count > 0) {
+            final_result.push_back({k, slot.sum_v * slot.match_count});
+        }
+    });
+
+    TABLE_STATS(groups.stats().print("streaming_pre_aggregation_join");)
+    return final_result;
+}
+
+// --- METHOD 3: Sort-Merge Join-Aggregation ---
+
+/**
+ * @brief Performs the join and aggregation by sorting both tables on k and merging them.
+ * Copies of A and B are radix-sorted; the merge then meets every key's run of A rows and
+ * run of B rows together, sums the A run and counts the B run. No hash table is built,
+ * and the groups come out in ascending order of k.
+ * @param table_a The vector for the left table (A).
+ * @param table_b The vector for the right table (B).
+ * @return A vector of AggregatedResult structs, sorted by k.
+ */
+std::vector<AggregatedResult> sort_merge_join_aggregate(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b) {
+    // 1. Sort: radix-sort copies of both tables by k.
+    std::vector<RowA> sorted_a = table_a;
+    std::vector<RowB> sorted_b = table_b;
+    radix_sort(sorted_a.data(), sorted_a.size(), [](const RowA& row) { return row.k; });
+    radix_sort(sorted_b.data(), sorted_b.size(), [](const RowB& row) { return row.k; });
+
+    // 2. Merge: skip runs of keys found on one side only, aggregate runs found on both.
+    std::vector<AggregatedResult> final_result;
+    size_t i = 0, j = 0;
+    while (i < sorted_a.size() && j < sorted_b.size()) {
+        int k = sorted_a[i].k;
+        if (k < sorted_b[j].k) {
+            ++i;
+        } else if (sorted_b[j].k < k) {
+            ++j;
+        } else {
+            long long sum_v = 0;
+            for (; i < sorted_a.size() && sorted_a[i].k == k; ++i) {
+                sum_v += sorted_a[i].v;
+            }
+            long long match_count = 0;
+            for (; j < sorted_b.size() && sorted_b[j].k == k; ++j) {
+                ++match_count;
+            }
+            final_result.push_back({k, sum_v * match_count});
+        }
+    }
     return final_result;
 }
 
+// --- Out-of-Core HashJoin-Then-Aggregation (Grace Hash Join) ---
+
+/**
+ * @brief Performs the hash join and aggregation straight from the input files under a memory budget.
+ * Rows stream from the files into grace_join, which spills hash partitions of A and B to
+ * disk once A's build side would exceed the budget. Each partition's A rows are built into a
+ * CsrHashTable, and every B row adds its matches' SUM(v) to the partition's aggregation
+ * table; no joined row is materialized. Partitions hold disjoint keys, so their groups are
+ * emitted as each one finishes, and neither the tables nor the result are held in memory.
+ * @param file_a The filename for the left table (A).
+ * @param file_b The filename for the right table (B).
+ * @param options The memory budget and spill directory; build_row_bytes is set here.
+ * @param load_options Read buffer size and I/O depth for streaming the files.
+ * @param emit Callable (int k, long long sum_v), called once per group that joined.
+ * @param stats Receives what was spilled and joined.
+ * @return false if a file could not be read or a spill file written.
+ */
+template <typename EmitFn>
+bool grace_hash_join_aggregate(const std::string& file_a, const std::string& file_b, GraceJoinOptions options,
+                               const LoadOptions& load_options, EmitFn emit, GraceJoinStats& stats) {
+    // Per A row: the row while building, its CSR entry and up to two bucket offsets, and at
+    // worst one aggregation slot (key and sum) per row at 3/4 load.
+    options.build_row_bytes = sizeof(RowA) + sizeof(CsrHashTable<int>::Entry) + 2 * sizeof(uint32_t)
+                            + 2 * (sizeof(int) + sizeof(long long));
+    auto scan_file = [&](const std::string& filename, auto parse_range) {
+        if (!for_each_line_chunk(filename, load_options.buffer_size, parse_range, nullptr, load_options.io_depth)) {
+            std::cerr << "Error: Could not read file " << filename << std::endl;
+            return false;
+        }
+        return true;
+    };
+    auto scan_a = [&](auto on_row) {
+        return scan_file(file_a, [&](const char* begin, const char* end) { scan_table<SchemaA>(begin, end, on_row, [](Field) {}); });
+    };
+    auto scan_b = [&](auto on_row) {
+        return scan_file(file_b, [&](const char* begin, const char* end) { scan_table<SchemaB>(begin, end, on_row, [](Field) {}); });
+    };
+
+    CsrHashTable<int> join_table;
+    FlatHashMap<int, long long> aggregation_map;
+    auto build = [&](const RowA* rows, size_t count) {
+        join_table = CsrHashTable<int>();
+        join_table.build(rows, count, [](const RowA& row) { return row.k; }, [](const RowA& row) { return row.v; });
+    };
+    auto probe = [&](const RowB* rows, size_t count) {
+        probe_batched(join_table, rows, count, kDefaultProbeBatch, [](const RowB& row) { return row.k; }, [&](const RowB& row_b) {
+            long long sum_v = 0;
+            bool matched = false;
+            join_table.for_each_match(row_b.k, [&](int a_v) {
+                sum_v += a_v;
+                matched = true;
+            });
+            if (matched) {
+                aggregation_map[row_b.k] += sum_v;
+            }
+        });
+    };
+    auto finish = [&]() {
+        TABLE_STATS(join_table.stats().print("grace_hash_join_aggregate join");)
+        TABLE_STATS(aggregation_map.stats().print("grace_hash_join_aggregate groups");)
+        aggregation_map.for_each([&](int k, long long sum_v) { emit(k, sum_v); });
+        join_table = CsrHashTable<int>();
+        aggregation_map = FlatHashMap<int, long long>();
+    };
+    return grace_join<RowA, RowB>(scan_a, scan_b, options, build, probe, finish, stats);
+}
+
 /**
  * @brief Sorts and saves the aggregated results to a CSV file.
  * @param filename The name of the output file.
  * @param results The vector of AggregatedResult structs to save.
+ * @param sorted_by_k True if results are already ordered by k (sort_merge_join_aggregate);
+ *        they are then written as they are, without copying and sorting them.
  */
-void save_results(const std::string& filename, const std::vector<AggregatedResult>& results) {
-    std::vector<AggregatedResult> sorted_results = results;
-
-    std::sort(sorted_results.begin(), sorted_results.end(), [](const AggregatedResult& a, const AggregatedResult& b){
-        return a.k < b.k;
-    });
+void save_results(const std::string& filename, const std::vector<AggregatedResult>& results, bool sorted_by_k = false) {
+    std::vector<AggregatedResult> sorted_results;
+    if (!sorted_by_k) {
+        sorted_results = results;
+        std::sort(sorted_results.begin(), sorted_results.end(), [](const AggregatedResult& a, const AggregatedResult& b){
+            return a.k < b.k;
+        });
+    }
+    const std::vector<AggregatedResult>& ordered_results = sorted_by_k ? results : sorted_results;
 
     std::ofstream output_file(filename);
     if (!output_file.is_open()) {
@@ -226,20 +773,292 @@ void save_results(const std::string& filename, const std::vector<AggregatedResul
     }
 
     output_file << "k,summ\n";
-    for (const auto& row : sorted_results) {
+    for (const auto& row : ordered_results) {
         output_file << row.k << "," << row.sum_v << "\n";
     }
     output_file.close();
 }
 
 
-int main() {
+/**
+ * @brief Loads both tables with 1..max_threads parser threads and prints the load throughput of each run.
+ * @param file_a The filename for the left table (A).
+ * @param file_b The filename for the right table (B).
+ * @param max_threads The largest thread count to measure.
+ */
+void report_ingest_scaling(const std::string& file_a, const std::string& file_b, int max_threads) {
+    std::cout << "threads,load_a_ms,load_a_gbps,load_b_ms,load_b_gbps" << std::endl;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        LoadStats load_a, load_b;
+        LoadOptions options;
+        options.num_threads = threads;
+        read_table_a(file_a, &load_a, options);
+        read_table_b(file_b, &load_b, options);
+        std::cout << threads << "," << load_a.millis << "," << load_a.gb_per_s() << ","
+                  << load_b.millis << "," << load_b.gb_per_s() << std::endl;
+    }
+}
+
+
+/**
+ * @brief Measures cold-cache load throughput: evicts both files from the page cache
+ * before each run, then loads them via mmap + parallel parsing and via the
+ * asynchronous reader at several I/O depths.
+ * @param file_a The filename for the left table (A).
+ * @param file_b The filename for the right table (B).
+ * @param base The thread count and buffer size to use.
+ */
+void report_cold_cache_io(const std::string& file_a, const std::string& file_b, const LoadOptions& base) {
+    std::cout << "mode,io_depth,load_a_ms,load_a_gbps,load_b_ms,load_b_gbps" << std::endl;
+    const int depths[] = {0, 1, 2, 4, 8}; // 0: mmap path
+    for (int depth : depths) {
+        if (!drop_file_cache(file_a) || !drop_file_cache(file_b)) {
+            std::cerr << "Warning: could not evict input files from the page cache" << std::endl;
+        }
+        LoadOptions options = base;
+        options.async_io = depth > 0;
+        options.io_depth = std::max(depth, 1);
+        LoadStats load_a, load_b;
+        read_table_a(file_a, &load_a, options);
+        read_table_b(file_b, &load_b, options);
+        std::cout << (options.async_io ? "async" : "mmap") << "," << depth << "," << load_a.millis << "," << load_a.gb_per_s() << ","
+                  << load_b.millis << "," << load_b.gb_per_s() << std::endl;
+    }
+}
+
+
+/**
+ * @brief Measures the hash_join and GroupJoin probe loops for several prefetch batch sizes on
+ * synthetic tables ranging from L2-resident to DRAM-resident, and prints ns per probe.
+ * Build keys are 0..rows-1 and probe keys are drawn from 0..2*rows-1, so about half the probes miss.
+ */
+void report_probe_prefetch() {
+    std::cout << "build_rows,batch,join_probe_ns,groupjoin_probe_ns" << std::endl;
+    const size_t num_probes = size_t(1) << 22;
+    const size_t batches[] = {1, 4, 8, 16, 32, 64};
+    std::mt19937 rng(42);
+    long long checksum = 0;
+    for (size_t rows = size_t(1) << 12; rows <= (size_t(1) << 24); rows <<= 2) {
+        std::vector<RowA> table_a(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            table_a[i] = {static_cast<int>(i), 1};
+        }
+        std::vector<RowB> probes(num_probes);
+        for (auto& row : probes) {
+            row.k = static_cast<int>(rng() % (2 * rows));
+        }
+        CsrHashTable<int> join_table;
+        join_table.build(table_a.data(), rows, [](const RowA& row) { return row.k; }, [](const RowA& row) { return row.v; });
+        FlatHashMap<int, GroupJoinSlot> groups(rows);
+        for (const auto& row : table_a) {
+            groups[row.k].sum_v += row.v;
+        }
+
+        for (size_t batch : batches) {
+            auto start = std::chrono::high_resolution_clock::now();
+            probe_batched(join_table, probes.data(), num_probes, batch, [](const RowB& row) { return row.k; },
+                [&](const RowB& row) { join_table.for_each_match(row.k, [&](int a_v) { checksum += a_v; }); });
+            auto middle = std::chrono::high_resolution_clock::now();
+            probe_batched(groups, probes.data(), num_probes, batch, [](const RowB& row) { return row.k; },
+                [&](const RowB& row) {
+                    if (GroupJoinSlot* slot = groups.find(row.k)) {
+                        slot->match_count++;
+                    }
+                });
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double, std::nano> join_ns = middle - start;
+            std::chrono::duration<double, std::nano> groupjoin_ns = end - middle;
+            std::cout << rows << "," << batch << "," << join_ns.count() / num_probes << ","
+                      << groupjoin_ns.count() / num_probes << std::endl;
+        }
+    }
+    if (checksum == 0) {
+        std::cerr << "Probe benchmark found no matches" << std::endl;
+    }
+}
+
+/**
+ * @brief Prints the cost of the radix-partitioned hash join per input row (ns/row) for several
+ * radix bit counts, next to the unpartitioned hash_join (radix_bits 0), as CSV.
+ * A has distinct keys 0..rows-1 and B draws its keys uniformly from twice that range, from
+ * cache-resident (1M rows per table) to DRAM-resident (16M rows) build sides.
+ */
+void report_radix_join() {
+    std::cout << "rows,radix_bits,passes,join_ns_per_row,matches" << std::endl;
+    const int radix_bits[] = {0, 4, 6, 8, 10, 12, 14, 16};
+    std::mt19937 rng(42);
+    for (size_t rows = size_t(1) << 20; rows <= (size_t(1) << 24); rows <<= 2) {
+        std::vector<RowA> table_a(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            table_a[i] = {static_cast<int>(i), 1};
+        }
+        std::shuffle(table_a.begin(), table_a.end(), rng);
+        std::vector<RowB> table_b(rows);
+        for (auto& row : table_b) {
+            row.k = static_cast<int>(rng() % (2 * rows));
+        }
+
+        for (int bits : radix_bits) {
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<JoinedRow> joined = bits == 0 ? hash_join(table_a, table_b) : radix_hash_join(table_a, table_b, bits);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double, std::nano> join_ns = end - start;
+            std::cout << rows << "," << bits << "," << (bits == 0 ? 0 : radix_passes(bits)) << ","
+                      << join_ns.count() / (2 * rows) << "," << joined.size() << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Runs grace_hash_join_aggregate from the files, without loading the tables, and writes
+ * the groups to Ds.txt as each partition finishes (ordered by partition, not by k).
+ * @param options The memory budget and spill directory.
+ */
+void report_grace_join(const std::string& file_a, const std::string& file_b, const GraceJoinOptions& options,
+                       const LoadOptions& load_options) {
+    std::ofstream output_file("Ds.txt");
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Could not open file for writing: Ds.txt" << std::endl;
+        return;
+    }
+    output_file << "k,summ\n";
+    size_t groups = 0;
+    GraceJoinStats stats;
+    auto start = std::chrono::high_resolution_clock::now();
+    bool ok = grace_hash_join_aggregate(file_a, file_b, options, load_options, [&](int k, long long sum_v) {
+        output_file << k << "," << sum_v << "\n";
+        ++groups;
+    }, stats);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    if (!ok) {
+        return;
+    }
+
+    std::cout << "Memory Budget: " << options.memory_budget / (1 << 20) << " MB (spill dir " << options.spill_dir << ")" << std::endl;
+    std::cout << "Grace Join: " << stats.partitions_joined << " partitions joined, " << stats.levels << " levels, "
+              << stats.repartitioned << " repartitioned, " << stats.over_budget << " over budget, "
+              << stats.bytes_spilled / double(1 << 20) << " MB spilled, peak build " << stats.peak_build_bytes / double(1 << 20)
+              << " MB" << std::endl;
+    std::cout << "Groups: " << groups << std::endl;
+    std::cout << "End-to-End Time (Grace-HashJoin-Aggregation): " << duration.count() << " ms" << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
     const std::string file_a_name = "A.txt";
     const std::string file_b_name = "B.txt";
 
+    // Usage: ./a.out [--threads=N] [--ingest-scaling] [--columnar] [--streaming] [--buffer-kb=N]
+    //               [--async-io] [--io-depth=N] [--cold-cache-io] [--swiss] [--dense-budget-mb=N]
+    //               [--probe-batch=N] [--probe-prefetch] [--bloom] [--radix-bits=N] [--radix-join]
+    //               [--sort-merge] [--auto-plan] [--llc-mb=N] [--late-materialize]
+    //               [--memory-budget-mb=N] [--spill-dir=PATH]
+    LoadOptions load_options;
+    load_options.num_threads = default_thread_count();
+    bool ingest_scaling = false;
+    bool columnar = false;
+    bool streaming = false;
+    bool cold_cache_io = false;
+    bool swiss = false;
+    uint64_t dense_budget = uint64_t(512) << 20; // Largest direct-addressed group table; 0 always hashes
+    size_t probe_batch = kDefaultProbeBatch;
+    bool probe_prefetch = false;
+    bool bloom = false;
+    int radix_bits = 0; // Partition bits of the radix hash join; 0 joins without partitioning
+    bool radix_join = false;
+    bool sort_merge = false;
+    bool auto_plan = false;
+    uint64_t llc_bytes = 0; // Last-level cache assumed by the cost model; 0 asks the OS
+    bool late_materialize = false; // Join emits A row indices; the aggregation gathers A's columns
+    GraceJoinOptions grace_options;
+    bool grace_join = false; // Only run the out-of-core join from the files, under grace_options.memory_budget
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0) {
+            load_options.num_threads = std::max(1, std::atoi(arg.c_str() + 10));
+        } else if (arg == "--ingest-scaling") {
+            ingest_scaling = true;
+        } else if (arg == "--columnar") {
+            columnar = true;
+        } else if (arg == "--streaming") {
+            streaming = true;
+        } else if (arg.rfind("--buffer-kb=", 0) == 0) {
+            load_options.buffer_size = static_cast<size_t>(std::max(1, std::atoi(arg.c_str() + 12))) * 1024;
+        } else if (arg == "--async-io") {
+            load_options.async_io = true;
+        } else if (arg.rfind("--io-depth=", 0) == 0) {
+            load_options.io_depth = std::max(1, std::atoi(arg.c_str() + 11));
+        } else if (arg == "--cold-cache-io") {
+            cold_cache_io = true;
+        } else if (arg == "--swiss") {
+            swiss = true;
+        } else if (arg.rfind("--dense-budget-mb=", 0) == 0) {
+            dense_budget = static_cast<uint64_t>(std::max(0, std::atoi(arg.c_str() + 18))) << 20;
+        } else if (arg.rfind("--probe-batch=", 0) == 0) {
+            probe_batch = static_cast<size_t>(std::max(1, std::atoi(arg.c_str() + 14)));
+        } else if (arg == "--probe-prefetch") {
+            probe_prefetch = true;
+        } else if (arg == "--bloom") {
+            bloom = true;
+        } else if (arg.rfind("--radix-bits=", 0) == 0) {
+            radix_bits = std::min(kMaxRadixBits, std::max(0, std::atoi(arg.c_str() + 13)));
+        } else if (arg == "--radix-join") {
+            radix_join = true;
+        } else if (arg == "--sort-merge") {
+            sort_merge = true;
+        } else if (arg == "--auto-plan") {
+            auto_plan = true;
+        } else if (arg.rfind("--llc-mb=", 0) == 0) {
+            llc_bytes = static_cast<uint64_t>(std::max(0, std::atoi(arg.c_str() + 9))) << 20;
+        } else if (arg == "--late-materialize") {
+            late_materialize = true;
+        } else if (arg.rfind("--memory-budget-mb=", 0) == 0) {
+            grace_options.memory_budget = static_cast<uint64_t>(std::max(1, std::atoi(arg.c_str() + 19))) << 20;
+            grace_join = true;
+        } else if (arg.rfind("--spill-dir=", 0) == 0) {
+            grace_options.spill_dir = arg.substr(12);
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (ingest_scaling) {
+        report_ingest_scaling(file_a_name, file_b_name, load_options.num_threads);
+        return 0;
+    }
+    if (cold_cache_io) {
+        report_cold_cache_io(file_a_name, file_b_name, load_options);
+        return 0;
+    }
+    if (probe_prefetch) {
+        report_probe_prefetch();
+        return 0;
+    }
+    if (radix_join) {
+        report_radix_join();
+        return 0;
+    }
+    if (grace_join) {
+        report_grace_join(file_a_name, file_b_name, grace_options, load_options);
+        return 0;
+    }
+
     // Load data into memory once
-    std::vector<RowA> table_a = read_table_a(file_a_name);
-    std::vector<RowB> table_b = read_table_b(file_b_name);
+    LoadStats load_a, load_b;
+    KeyDomain domain_a;
+    HyperLogLog sketch_a, sketch_b;
+    std::vector<RowA> table_a;
+    std::vector<RowB> table_b;
+    if (columnar) {
+        // Binary tables produced by: ./csv_to_columnar A.txt A.col && ./csv_to_columnar B.txt B.col
+        table_a = read_table_a_columnar("A.col", &load_a, &domain_a, &sketch_a);
+        table_b = read_table_b_columnar("B.col", &load_b, &sketch_b);
+    } else {
+        table_a = read_table_a(file_a_name, &load_a, load_options, &domain_a, &sketch_a);
+        table_b = read_table_b(file_b_name, &load_b, load_options, &sketch_b);
+    }
 
     if (table_a.empty()) {
         std::cerr << "Table 1 issue!" << std::endl;
@@ -250,11 +1069,66 @@ int main() {
         return 1;
     }
 
+    std::cout << "Load Time (A): " << load_a.millis << " ms (" << load_a.gb_per_s() << " GB/s)" << std::endl;
+    std::cout << "Load Time (B): " << load_b.millis << " ms (" << load_b.gb_per_s() << " GB/s)" << std::endl;
+    std::cout << "Load Threads: " << load_options.num_threads << (load_options.async_io ? " (async I/O)" : "") << std::endl;
+    std::cout << "Hash Tables: " << (swiss ? "swiss" : "csr/flat") << std::endl;
+    if (radix_bits > 0) {
+        std::cout << "Hash Join: radix-partitioned, " << radix_bits << " bits (" << (size_t(1) << radix_bits)
+                  << " partitions, " << radix_passes(radix_bits) << " pass" << (radix_passes(radix_bits) > 1 ? "es" : "") << ")" << std::endl;
+    }
+
+    // Distinct keys estimated while loading; the keys A and B share follow from the sketch of their union.
+    HyperLogLog sketch_union = sketch_a;
+    sketch_union.merge(sketch_b);
+    size_t distinct_a = sketch_a.estimate();
+    size_t distinct_b = sketch_b.estimate();
+    size_t distinct_union = sketch_union.estimate();
+    size_t distinct_shared = distinct_a + distinct_b > distinct_union ? distinct_a + distinct_b - distinct_union : 0;
+    std::cout << "Distinct Keys (A): ~" << distinct_a << " (" << static_cast<double>(distinct_a) / table_a.size() << " of rows)" << std::endl;
+    std::cout << "Distinct Keys (B): ~" << distinct_b << " (" << static_cast<double>(distinct_b) / table_b.size() << " of rows)" << std::endl;
+    std::cout << "Distinct Keys (A and B): ~" << distinct_shared << std::endl;
+
+    // Aggregate over plain arrays indexed by (k - min) when A's key range fits the budget.
+    uint64_t dense_bytes = DenseArrayMap<GroupJoinSlot>::bytes_for(domain_a);
+    bool dense = !domain_a.empty() && dense_bytes <= dense_budget;
+    std::cout << "Group Tables: " << (dense ? "dense array" : "hash") << " (keys " << domain_a.min << ".." << domain_a.max
+              << ", " << dense_bytes / (1 << 20) << " MB direct-addressed, budget " << dense_budget / (1 << 20) << " MB)" << std::endl;
+
+    // Both methods with the table choices above; a non-null BloomFilterStats enables the Bloom filter.
+    // Hash tables are reserved from the estimates: the join and GroupJoin tables hold A's keys,
+    // the aggregation holds the keys that joined.
+    size_t join_matches = 0;
+    auto hash_join_then_aggregation = [&](BloomFilterStats* bloom_stats) {
+        if (late_materialize) {
+            std::vector<uint32_t> a_rows =
+                radix_bits > 0 ? (swiss ? radix_hash_join_row_ids<SwissJoinTable<uint32_t>>(table_a, table_b, radix_bits, probe_batch)
+                                        : radix_hash_join_row_ids(table_a, table_b, radix_bits, probe_batch))
+                : swiss ? hash_join_row_ids<SwissJoinTable<uint32_t>>(table_a, table_b, probe_batch, bloom_stats, distinct_a)
+                        : hash_join_row_ids(table_a, table_b, probe_batch, bloom_stats, distinct_a);
+            join_matches = a_rows.size();
+            return dense ? aggregate_row_ids(a_rows, table_a, DenseArrayMap<long long>(domain_a))
+                         : aggregate_row_ids(a_rows, table_a, presized<FlatHashMap<int, long long>>(distinct_shared));
+        }
+        std::vector<JoinedRow> joined_table =
+            radix_bits > 0 ? (swiss ? radix_hash_join<SwissJoinTable<int>>(table_a, table_b, radix_bits, probe_batch)
+                                    : radix_hash_join(table_a, table_b, radix_bits, probe_batch))
+            : swiss ? hash_join<SwissJoinTable<int>>(table_a, table_b, probe_batch, bloom_stats, distinct_a)
+                    : hash_join(table_a, table_b, probe_batch, bloom_stats, distinct_a);
+        join_matches = joined_table.size();
+        return dense ? perform_aggregation(joined_table, DenseArrayMap<long long>(domain_a))
+                     : perform_aggregation(joined_table, presized<FlatHashMap<int, long long>>(distinct_shared));
+    };
+    auto group_join = [&](BloomFilterStats* bloom_stats) {
+        return dense ? pre_aggregation_join(table_a, table_b, DenseArrayMap<GroupJoinSlot>(domain_a), probe_batch, bloom_stats)
+               : swiss ? pre_aggregation_join(table_a, table_b, presized<SwissHashMap<int, GroupJoinSlot>>(distinct_a), probe_batch, bloom_stats)
+                       : pre_aggregation_join(table_a, table_b, presized<FlatHashMap<int, GroupJoinSlot>>(distinct_a), probe_batch, bloom_stats);
+    };
+
     // --- Method 1: HashJoin-Then-Aggregation ---
     auto start1 = std::chrono::high_resolution_clock::now();
     
-    std::vector<JoinedRow> joined_table = hash_join(table_a, table_b);
-    std::vector<AggregatedResult> final_results_1 = perform_aggregation(joined_table);
+    std::vector<AggregatedResult> final_results_1 = hash_join_then_aggregation(nullptr);
     
     auto end1 = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> duration1 = end1 - start1;
@@ -263,7 +1137,7 @@ int main() {
     // --- Method 2: GroupJoin (Pre-Aggregation) ---
     auto start2 = std::chrono::high_resolution_clock::now();
     
-    std::vector<AggregatedResult> final_results_2 = pre_aggregation_join(table_a, table_b);
+    std::vector<AggregatedResult> final_results_2 = group_join(nullptr);
 
     auto end2 = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> duration2 = end2 - start2;
@@ -282,8 +1156,132 @@ int main() {
         std::cout << "Fatal Error:" << std::endl;
     }
 
+
+    // Intermediate written between the join and the aggregation, in either join output
+    std::cout << "Join Output: " << join_matches << " matches, "
+              << join_matches * (late_materialize ? sizeof(uint32_t) : sizeof(JoinedRow)) / double(1 << 20) << " MB as "
+              << (late_materialize ? "A row ids" : "JoinedRow") << " (" << join_matches * sizeof(JoinedRow) / double(1 << 20)
+              << " MB materialized)" << std::endl;
+
+    // --- Both methods again with B's keys checked against a Bloom filter of A's keys first ---
+    if (bloom) {
+        // The radix-partitioned join has no Bloom filter, so only GroupJoin is rerun for it.
+        BloomFilterStats join_bloom, groupjoin_bloom;
+        auto start4 = std::chrono::high_resolution_clock::now();
+        std::vector<AggregatedResult> filtered_results_1;
+        if (radix_bits == 0) {
+            filtered_results_1 = hash_join_then_aggregation(&join_bloom);
+        }
+        auto end4 = std::chrono::high_resolution_clock::now();
+        std::vector<AggregatedResult> filtered_results_2 = group_join(&groupjoin_bloom);
+        auto end5 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration4 = end4 - start4;
+        std::chrono::duration<double, std::milli> duration5 = end5 - end4;
+
+        if (radix_bits > 0) {
+            std::cout << "Bloom Filter Selectivity: n/a (radix join)" << std::endl;
+            std::cout << "Bloom Filter Time (HashJoin-Then-Aggregation): n/a (radix join)" << std::endl;
+        } else {
+            std::cout << "Bloom Filter Selectivity: " << join_bloom.selectivity() * 100 << "% of " << join_bloom.probes
+                      << " B probes passed" << std::endl;
+            std::cout << "Bloom Filter Time (HashJoin-Then-Aggregation): " << duration4.count() << " ms (saved "
+                      << duration1.count() - duration4.count() << " ms)" << std::endl;
+        }
+        std::cout << "Bloom Filter Time (GroupJoin): " << duration5.count() << " ms (saved "
+                  << duration2.count() - duration5.count() << " ms)" << std::endl;
+        if ((radix_bits == 0 && filtered_results_1.size() != final_results_1.size())
+            || filtered_results_2.size() != final_results_2.size()) {
+            std::cerr << "Bloom-filtered joins produced a different number of groups" << std::endl;
+        }
+    }
+
+    // --- Method 3: Sort-Merge Join-Aggregation, whose groups come out ordered by k ---
+    std::vector<AggregatedResult> final_results_6;
+    std::chrono::duration<double, std::milli> duration6(0);
+    if (sort_merge) {
+        auto start6 = std::chrono::high_resolution_clock::now();
+        final_results_6 = sort_merge_join_aggregate(table_a, table_b);
+        auto end6 = std::chrono::high_resolution_clock::now();
+        duration6 = end6 - start6;
+
+        std::cout << "Execution Time (SortMerge-Join-Aggregation): " << duration6.count() << " ms" << std::endl;
+        if (final_results_6.size() != final_results_2.size()) {
+            std::cerr << "Sort-merge join produced " << final_results_6.size() << " groups, expected " << final_results_2.size() << std::endl;
+        }
+    }
+
+    // --- Cost-based choice: predicted vs. measured time of each plan, then the chosen plan ---
+    if (auto_plan) {
+        JoinStatistics query;
+        query.rows_a = table_a.size();
+        query.rows_b = table_b.size();
+        query.distinct_a = distinct_a;
+        query.distinct_b = distinct_b;
+        query.distinct_shared = distinct_shared;
+        KeyDomain keys = domain_a;
+        for (const RowB& row : table_b) {
+            keys.add(row.k);
+        }
+        query.min_key = keys.min;
+        query.max_key = keys.max;
+        query.join_table_bytes = swiss ? hash_table_bytes(distinct_a, 1 + sizeof(int) + 2 * sizeof(uint32_t)) + table_a.size() * sizeof(int)
+                                       : hash_table_bytes(table_a.size(), sizeof(uint32_t)) * 3 / 4 + table_a.size() * sizeof(CsrHashTable<int>::Entry);
+        query.join_table_bytes >>= radix_bits; // One partition's table at a time
+        query.aggregation_bytes = dense ? DenseArrayMap<long long>::bytes_for(domain_a)
+                                        : hash_table_bytes(distinct_shared, sizeof(int) + sizeof(long long));
+        query.group_table_bytes = dense ? dense_bytes : hash_table_bytes(distinct_a, (swiss ? 1 : 0) + sizeof(int) + sizeof(GroupJoinSlot));
+        query.dense_groups = dense;
+
+        CostModel model = CostModel::for_this_machine();
+        if (llc_bytes > 0) {
+            model.llc_bytes = llc_bytes;
+        }
+        PlanCosts predicted = model.estimate(query);
+        JoinPlan plan = predicted.best();
+        auto start7 = std::chrono::high_resolution_clock::now();
+        std::vector<AggregatedResult> plan_results = plan == JoinPlan::HashJoinThenAggregation ? hash_join_then_aggregation(nullptr)
+                                                   : plan == JoinPlan::GroupJoin ? group_join(nullptr)
+                                                                                 : sort_merge_join_aggregate(table_a, table_b);
+        auto end7 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration7 = end7 - start7;
+
+        std::cout << "Plan Statistics: join_rows=~" << static_cast<size_t>(query.join_rows()) << " groups=~" << distinct_shared
+                  << " join_table=" << query.join_table_bytes / (1 << 20) << " MB group_table=" << query.group_table_bytes / (1 << 20)
+                  << " MB llc=" << model.llc_bytes / (1 << 20) << " MB" << std::endl;
+        const double measured[kNumJoinPlans] = {duration1.count(), duration2.count(), sort_merge ? duration6.count() : -1.0};
+        for (int i = 0; i < kNumJoinPlans; ++i) {
+            std::cout << "Plan Cost (" << plan_name(static_cast<JoinPlan>(i)) << "): predicted " << predicted.seconds[i] * 1e3 << " ms";
+            if (measured[i] >= 0) {
+                std::cout << ", measured " << measured[i] << " ms";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "Chosen Plan: " << plan_name(plan) << " (predicted " << predicted[plan] * 1e3 << " ms, actual "
+                  << duration7.count() << " ms)" << std::endl;
+        if (plan_results.size() != final_results_2.size()) {
+            std::cerr << "Chosen plan produced " << plan_results.size() << " groups, expected " << final_results_2.size() << std::endl;
+        }
+    }
+
+    // --- GroupJoin end-to-end: in-memory (load + join) vs. streaming from the files ---
+    if (streaming) {
+        auto start3 = std::chrono::high_resolution_clock::now();
+        std::vector<AggregatedResult> final_results_3 = streaming_pre_aggregation_join(file_a_name, file_b_name, load_options.buffer_size, load_options.io_depth);
+        auto end3 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration3 = end3 - start3;
+
+        std::cout << "End-to-End Time (Load + GroupJoin): " << (load_a.millis + load_b.millis) + duration2.count() << " ms" << std::endl;
+        std::cout << "End-to-End Time (Streaming GroupJoin): " << duration3.count() << " ms" << std::endl;
+        if (final_results_3.size() != final_results_2.size()) {
+            std::cerr << "Streaming GroupJoin produced " << final_results_3.size() << " groups, expected " << final_results_2.size() << std::endl;
+        }
+    }
+
     save_results("As.txt", final_results_1);
     save_results("Bs.txt", final_results_2);
+    if (sort_merge) {
+        save_results("Cs.txt", final_results_6, true);
+    }
 
     return 0;
 }
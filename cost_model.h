@@ -0,0 +1,206 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+
+// -- Cost-based choice between the join-aggregation strategies --
+//
+// The table statistics gathered while loading (row counts, HyperLogLog distinct
+// keys of A, B and both, the key range of both) are enough to estimate, per strategy,
+// how many random accesses it makes into which table and how large that table
+// is. A random access costs more once its table outgrows the L2 cache and the
+// last-level cache, so each strategy's cost is the sum of its accesses priced
+// by footprint, plus its hashing and sequential work. The constants below were
+// fitted (least squares on relative error) to the 100K-10M row benchmark grid
+// of a 1-vCPU VM, whose effective last-level cache behaved like 8 MB; main
+// prints predicted next to measured times so they can be refitted elsewhere.
+
+enum class JoinPlan {
+    HashJoinThenAggregation,
+    GroupJoin,
+    SortMerge,
+};
+
+constexpr int kNumJoinPlans = 3;
+
+/**
+ * @brief The name under which main reports the plan's execution time.
+ */
+inline const char* plan_name(JoinPlan plan) {
+    switch (plan) {
+        case JoinPlan::HashJoinThenAggregation: return "HashJoin-Then-Aggregation";
+        case JoinPlan::GroupJoin: return "GroupJoin";
+        case JoinPlan::SortMerge: return "SortMerge-Join-Aggregation";
+    }
+    return "?";
+}
+
+/**
+ * @brief Bytes of an open-addressing table holding keys entries of entry_bytes at most 3/4 full.
+ */
+inline uint64_t hash_table_bytes(size_t keys, size_t entry_bytes) {
+    uint64_t capacity = 16;
+    while (capacity * 3 < static_cast<uint64_t>(keys) * 4) {
+        capacity *= 2;
+    }
+    return capacity * entry_bytes;
+}
+
+/**
+ * @brief What the cost model knows about one join-aggregation query.
+ */
+struct JoinStatistics {
+    size_t rows_a = 0;
+    size_t rows_b = 0;
+    size_t distinct_a = 0;
+    size_t distinct_b = 0;
+    size_t distinct_shared = 0;       // Keys present in both tables
+    int min_key = 0;                  // min(k) over A and B
+    int max_key = -1;                 // max(k) over A and B; below min_key if both are empty
+    uint64_t join_table_bytes = 0;    // Build side of hash_join
+    uint64_t aggregation_bytes = 0;   // perform_aggregation's table
+    uint64_t group_table_bytes = 0;   // pre_aggregation_join's table
+    bool dense_groups = false;        // Both aggregations index arrays instead of hashing
+
+    /**
+     * @brief Estimated rows produced by the join: every B row of a shared key meets
+     * that key's A rows, assuming duplicates spread evenly over each table's keys.
+     */
+    double join_rows() const {
+        if (distinct_a == 0 || distinct_b == 0) {
+            return 0.0;
+        }
+        double shared_b_rows = static_cast<double>(rows_b) * distinct_shared / distinct_b;
+        return shared_b_rows * rows_a / distinct_a;
+    }
+
+    // LSD passes radix_sort makes over keys in [min_key, max_key]. It skips a byte that is the
+    // same for every key once the sign bit is flipped; over a whole range those are exactly the
+    // bytes above the highest one in which the flipped min_key and max_key differ (the flip
+    // cancels out of the XOR, but a range crossing zero differs in the sign byte).
+    int sort_passes() const {
+        if (max_key <= min_key) {
+            return 0;
+        }
+        uint32_t differing = static_cast<uint32_t>(min_key) ^ static_cast<uint32_t>(max_key);
+        int passes = 0;
+        while (differing != 0) {
+            ++passes;
+            differing >>= 8;
+        }
+        return passes;
+    }
+};
+
+/**
+ * @brief Predicted seconds per plan, indexed by JoinPlan.
+ */
+struct PlanCosts {
+    double seconds[kNumJoinPlans] = {};
+
+    double operator[](JoinPlan plan) const { return seconds[static_cast<int>(plan)]; }
+
+    JoinPlan best() const {
+        return static_cast<JoinPlan>(std::min_element(seconds, seconds + kNumJoinPlans) - seconds);
+    }
+};
+
+struct CostModel {
+    uint64_t l2_bytes = uint64_t(2) << 20;
+    uint64_t llc_bytes = uint64_t(8) << 20;
+
+    // Nanoseconds per random table access whose table fits L2, fits the LLC, or lives in DRAM.
+    double l2_access_ns = 2.5;
+    double llc_access_ns = 16.0;
+    double dram_access_ns = 24.0;
+    double hash_ns = 5.0;            // Hashing and probing a hash table, on top of its accesses
+    double row_copy_ns = 5.5;        // Sequential work per row (copy, scan, emit)
+    double sort_pass_ns = 0.5;       // One radix scatter pass per row, cache-resident
+    double sort_miss_ns = 7.5;       // Extra per row and pass once the sorted arrays outgrow the LLC
+    double merge_run_ns = 11.5;      // Per key run the merge steps over
+    double plan_setup_ns = 20000.0;  // Allocating and releasing a plan's tables
+
+    /**
+     * @brief The model with this machine's L2 and last-level cache sizes, where the OS reports them.
+     * Under virtualization the reported LLC may be the whole host's; override llc_bytes then.
+     */
+    static CostModel for_this_machine() {
+        CostModel model;
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+        long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (l2 > 0) {
+            model.l2_bytes = static_cast<uint64_t>(l2);
+        }
+        model.llc_bytes = std::max(model.l2_bytes, l3 > 0 ? static_cast<uint64_t>(l3) : model.llc_bytes);
+#endif
+        return model;
+    }
+
+    /**
+     * @brief Average cost of one random access into a table of footprint bytes. Beyond a cache
+     * level, the share of accesses that still hit it shrinks with cache size / footprint.
+     */
+    double access_ns(uint64_t footprint) const {
+        if (footprint <= l2_bytes) {
+            return l2_access_ns;
+        }
+        double llc_hits = std::min(1.0, static_cast<double>(llc_bytes) / footprint);
+        double l2_hits = static_cast<double>(l2_bytes) / footprint;
+        return l2_hits * l2_access_ns + (llc_hits - l2_hits) * llc_access_ns + (1.0 - llc_hits) * dram_access_ns;
+    }
+
+    /**
+     * @brief Cost of one hash table lookup. The tables keep keys and payloads (or bucket offsets
+     * and entries) in separate arrays, so a lookup makes two accesses into half the footprint each.
+     */
+    double hashed_access_ns(uint64_t footprint) const {
+        return 2 * access_ns(footprint / 2) + hash_ns;
+    }
+
+    /**
+     * @brief Share of random accesses into footprint bytes that go to DRAM.
+     */
+    double dram_share(uint64_t footprint) const {
+        return footprint <= llc_bytes ? 0.0 : 1.0 - static_cast<double>(llc_bytes) / footprint;
+    }
+
+    PlanCosts estimate(const JoinStatistics& stats) const {
+        const double rows_a = static_cast<double>(stats.rows_a);
+        const double rows_b = static_cast<double>(stats.rows_b);
+        const double join_rows = stats.join_rows();
+        const double groups = static_cast<double>(stats.distinct_shared);
+        auto group_access_ns = [&](uint64_t footprint) {
+            return stats.dense_groups ? access_ns(footprint) : hashed_access_ns(footprint);
+        };
+        PlanCosts costs;
+
+        // Build: count and scatter A (two lookups per row); probe with B; aggregate the joined rows.
+        costs.seconds[static_cast<int>(JoinPlan::HashJoinThenAggregation)] =
+            (2 * rows_a + rows_b) * hashed_access_ns(stats.join_table_bytes)
+            + join_rows * group_access_ns(stats.aggregation_bytes) + (rows_a + groups) * row_copy_ns;
+
+        // One lookup per A row to build the groups, one per B row to probe them.
+        double group_access = group_access_ns(stats.group_table_bytes);
+        costs.seconds[static_cast<int>(JoinPlan::GroupJoin)] =
+            (rows_a + rows_b) * group_access + stats.distinct_a * row_copy_ns;
+
+        // Copy, radix-sort and merge both tables: sequential passes, except the scatters miss
+        // once the arrays outgrow the LLC.
+        const double sorted_rows = rows_a + rows_b;
+        const uint64_t sort_bytes = 2 * (stats.rows_a * 8 + stats.rows_b * 4);  // (k, v) and (k) rows, and their scratch copies
+        costs.seconds[static_cast<int>(JoinPlan::SortMerge)] =
+            sorted_rows * stats.sort_passes() * (sort_pass_ns + sort_miss_ns * dram_share(sort_bytes))
+            + (2 * sorted_rows + groups) * row_copy_ns + static_cast<double>(stats.distinct_a + stats.distinct_b) * merge_run_ns;
+
+        for (double& seconds : costs.seconds) {
+            seconds = (seconds + plan_setup_ns) * 1e-9;
+        }
+        return costs;
+    }
+};
+
+#endif // COST_MODEL_H
@@ -0,0 +1,136 @@
+#ifndef CSR_HASH_TABLE_H
+#define CSR_HASH_TABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "hash_policy.h"
+#include "table_stats.h"
+
+// -- Multi-valued hash table in CSR (compressed sparse row) layout --
+//
+// Built in two passes over the input: the first counts rows per hash bucket,
+// a prefix sum turns the counts into bucket offsets, and the second scatters
+// (key, payload) entries into one contiguous array. All duplicates of a key
+// share a bucket and therefore sit next to each other, and the build performs
+// exactly two allocations (offsets and entries) however many keys there are.
+
+/**
+ * @brief Read-only hash table from int keys to every payload stored under them.
+ * @tparam Payload The value stored with each key.
+ * @tparam Hash Hash policy (see hash_policy.h); buckets are picked from its high bits.
+ */
+template <typename Payload, typename Hash = MultiplyShiftHash>
+class CsrHashTable {
+public:
+    struct Entry {
+        int key;
+        Payload value;
+    };
+
+    /**
+     * @brief Builds the table from rows[0..count).
+     * @param rows Random-access input rows.
+     * @param count Number of rows; must be below 2^32.
+     * @param key_of Callable (const Row&) -> int.
+     * @param payload_of Callable (const Row&) -> Payload.
+     */
+    template <typename Row, typename KeyFn, typename PayloadFn>
+    void build(const Row* rows, size_t count, KeyFn key_of, PayloadFn payload_of) {
+        num_buckets_ = 16;
+        while (num_buckets_ < count) {
+            num_buckets_ *= 2;
+        }
+        shift_ = 64 - __builtin_ctzll(num_buckets_);
+        size_ = count;
+
+        // Pass 1: count rows per bucket, then turn the counts into bucket end offsets.
+        offsets_.reset(new uint32_t[num_buckets_ + 1]());
+        for (size_t i = 0; i < count; ++i) {
+            offsets_[bucket_of(key_of(rows[i]))]++;
+        }
+        uint32_t sum = 0;
+        for (size_t b = 0; b < num_buckets_; ++b) {
+            sum += offsets_[b];
+            offsets_[b] = sum;
+        }
+        offsets_[num_buckets_] = sum;
+
+        // Pass 2: scatter back to front; each bucket's end offset walks down to its start,
+        // and entries keep their input order within a bucket.
+        entries_.reset(new Entry[count]);
+        for (size_t i = count; i-- > 0;) {
+            int key = key_of(rows[i]);
+            entries_[--offsets_[bucket_of(key)]] = {key, payload_of(rows[i])};
+        }
+        TABLE_STATS(stats_.bytes_allocated = (num_buckets_ + 1) * sizeof(uint32_t) + count * sizeof(Entry);)
+    }
+
+    /**
+     * @brief Calls fn(const Payload&) for every entry stored under key, in input order.
+     */
+    template <typename Fn>
+    void for_each_match(int key, Fn&& fn) const {
+        size_t b = bucket_of(key);
+        TABLE_STATS(bool hit = false;)
+        for (uint32_t i = offsets_[b], end = offsets_[b + 1]; i < end; ++i) {
+            if (entries_[i].key == key) {
+                fn(entries_[i].value);
+                TABLE_STATS(hit = true;)
+            }
+        }
+        TABLE_STATS(stats_.record_probe(std::max<size_t>(1, offsets_[b + 1] - offsets_[b]), hit);)
+    }
+
+    /**
+     * @brief Starts loading the bucket offsets of key into cache ahead of for_each_match.
+     */
+    void prefetch(int key) const {
+        __builtin_prefetch(&offsets_[bucket_of(key)]);
+    }
+
+    /**
+     * @brief Second prefetch stage: reads the bucket's start offset (loaded by prefetch) and
+     * starts loading its first entries.
+     */
+    void prefetch_matches(int key) const {
+        __builtin_prefetch(&entries_[offsets_[bucket_of(key)]]);
+    }
+
+    /**
+     * @brief No-op: build sizes the table from its row count and never rehashes. Probes that miss
+     * stay cheap with one bucket per row, so a distinct-key estimate is not used to shrink it.
+     */
+    void reserve(size_t) {}
+
+    size_t size() const { return size_; }
+    size_t num_buckets() const { return num_buckets_; }
+
+#ifdef HASH_TABLE_STATS
+    /**
+     * @brief Lookup and allocation counters; probe lengths count the entries of the bucket scanned.
+     */
+    TableStats stats() const {
+        TableStats stats = stats_;
+        stats.size = size_;
+        stats.capacity = num_buckets_;
+        return stats;
+    }
+#endif
+
+private:
+    size_t bucket_of(int key) const {
+        return static_cast<size_t>(Hash::hash(static_cast<uint64_t>(static_cast<uint32_t>(key))) >> shift_);
+    }
+
+    std::unique_ptr<uint32_t[]> offsets_;
+    std::unique_ptr<Entry[]> entries_;
+    size_t num_buckets_ = 0;
+    unsigned shift_ = 64;
+    size_t size_ = 0;
+    TABLE_STATS(mutable TableStats stats_;)
+};
+
+#endif // CSR_HASH_TABLE_H
@@ -0,0 +1,308 @@
+#ifndef CSV_SCAN_H
+#define CSV_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// -- Vectorized CSV scanning and integer decoding --
+//
+// The scanner builds a 64-bit bitmap of delimiter/newline positions for each
+// 64-byte block (AVX2: 2 x 32 bytes, SSE2: 4 x 16 bytes, otherwise scalar) and
+// then walks the set bits, so the per-byte work is a handful of vector compares.
+// Integers are decoded eight digits at a time with SWAR arithmetic.
+
+/**
+ * @brief A [begin, end) view of one field or one line inside the input buffer.
+ */
+struct Field {
+    const char* begin;
+    const char* end;
+};
+
+// Fields beyond this count are still counted but not recorded.
+constexpr size_t kMaxFields = 16;
+
+/**
+ * @brief Yields the positions of delimiter and '\n' characters in a buffer, in order.
+ */
+class StructuralScanner {
+public:
+    StructuralScanner(const char* begin, const char* end, char delimiter)
+        : block_(begin), end_(end), delimiter_(delimiter) {
+        load_block(begin);
+    }
+
+    /**
+     * @brief Returns the next delimiter or newline position, or end once the buffer is exhausted.
+     */
+    const char* next() {
+        while (mask_ == 0) {
+            if (!advance()) {
+                return end_;
+            }
+        }
+        const char* pos = block_ + __builtin_ctzll(mask_);
+        mask_ &= mask_ - 1;
+        return pos;
+    }
+
+    /**
+     * @brief Skips any remaining delimiters on the current line.
+     * @return The position of the next '\n', or end once the buffer is exhausted.
+     */
+    const char* next_newline() {
+        while ((mask_ & newlines_) == 0) {
+            if (!advance()) {
+                return end_;
+            }
+        }
+        uint64_t bit = (mask_ & newlines_) & (0 - (mask_ & newlines_));
+        mask_ &= ~((bit << 1) - 1);
+        return block_ + __builtin_ctzll(bit);
+    }
+
+    /**
+     * @brief Like next_newline, but adds the number of delimiters skipped to delimiters.
+     */
+    const char* next_newline(size_t& delimiters) {
+        while ((mask_ & newlines_) == 0) {
+            delimiters += __builtin_popcountll(mask_);
+            if (!advance()) {
+                return end_;
+            }
+        }
+        uint64_t bit = (mask_ & newlines_) & (0 - (mask_ & newlines_));
+        delimiters += __builtin_popcountll(mask_ & (bit - 1));
+        mask_ &= ~((bit << 1) - 1);
+        return block_ + __builtin_ctzll(bit);
+    }
+
+private:
+    bool advance() {
+        if (end_ - block_ <= 64) {
+            block_ = end_;
+            mask_ = newlines_ = 0;
+            return false;
+        }
+        block_ += 64;
+        load_block(block_);
+        return true;
+    }
+
+    // Sets mask_ to the delimiter|newline bitmap of the 64 bytes at p and newlines_ to the newline bitmap.
+    void load_block(const char* p) {
+        uint64_t delims = 0;
+        uint64_t newlines = 0;
+        if (end_ - p < 64) {
+            for (int i = 0; p + i < end_; ++i) {
+                delims |= uint64_t(p[i] == delimiter_) << i;
+                newlines |= uint64_t(p[i] == '\n') << i;
+            }
+        } else {
+#if defined(__AVX2__)
+            const __m256i delim = _mm256_set1_epi8(delimiter_);
+            const __m256i newline = _mm256_set1_epi8('\n');
+            for (int i = 0; i < 2; ++i) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+                delims |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, delim)))) << (32 * i);
+                newlines |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)))) << (32 * i);
+            }
+#elif defined(__SSE2__)
+            const __m128i delim = _mm_set1_epi8(delimiter_);
+            const __m128i newline = _mm_set1_epi8('\n');
+            for (int i = 0; i < 4; ++i) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+                delims |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, delim)))) << (16 * i);
+                newlines |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)))) << (16 * i);
+            }
+#else
+            for (int i = 0; i < 64; ++i) {
+                delims |= uint64_t(p[i] == delimiter_) << i;
+                newlines |= uint64_t(p[i] == '\n') << i;
+            }
+#endif
+        }
+        mask_ = delims | newlines;
+        newlines_ = newlines;
+    }
+
+    const char* block_;
+    const char* end_;
+    char delimiter_;
+    uint64_t mask_ = 0;
+    uint64_t newlines_ = 0;
+};
+
+/**
+ * @brief Splits [begin, end) into lines and fields and calls on_row for every line.
+ * @param begin Start of the buffer; must be at the beginning of a line.
+ * @param end End of the buffer.
+ * @param delimiter The field delimiter.
+ * @param on_row Callable (const Field* fields, size_t count, Field line). Only the
+ *               first kMaxFields fields are recorded when count exceeds it.
+ */
+template <typename RowFn>
+void scan_rows(const char* begin, const char* end, char delimiter, RowFn&& on_row) {
+    StructuralScanner scanner(begin, end, delimiter);
+    Field fields[kMaxFields];
+    size_t count = 0;
+    const char* line = begin;
+    const char* field = begin;
+    while (line < end) {
+        const char* pos = scanner.next();
+        if (count < kMaxFields) {
+            fields[count] = {field, pos};
+        }
+        ++count;
+        if (pos == end || *pos == '\n') {
+            on_row(static_cast<const Field*>(fields), count, Field{line, pos});
+            count = 0;
+            line = field = (pos == end) ? end : pos + 1;
+        } else {
+            field = pos + 1;
+        }
+    }
+}
+
+/**
+ * @brief Like scan_rows, but only records the requested columns of each line.
+ * Fields between the requested columns are skipped without being recorded or
+ * trimmed, and everything after the last requested column is skipped straight
+ * to the next newline, so the per-row cost scales with the projected columns
+ * rather than the row width.
+ * @param begin Start of the buffer; must be at the beginning of a line.
+ * @param end End of the buffer.
+ * @param delimiter The field delimiter.
+ * @param columns Zero-based column indices to extract, in ascending order.
+ * @param num_columns Number of entries in columns (at most kMaxFields).
+ * @param count_fields If true, the delimiters after the last requested column are counted
+ *                     while skipping them, so the line's field count is known.
+ * @param on_row Callable (const Field* projected, size_t found, size_t num_fields, Field line);
+ *               found is the number of requested columns present on the line, num_fields the
+ *               number of fields on it (only if count_fields, or if the line ended early).
+ */
+template <typename RowFn>
+void scan_projected_rows(const char* begin, const char* end, char delimiter,
+                         const size_t* columns, size_t num_columns, bool count_fields, RowFn&& on_row) {
+    StructuralScanner scanner(begin, end, delimiter);
+    Field projected[kMaxFields];
+    const char* line = begin;
+    while (line < end) {
+        const char* field = line;
+        const char* pos = line;
+        size_t column = 0;
+        size_t found = 0;
+        while (found < num_columns) {
+            pos = scanner.next();
+            if (column == columns[found]) {
+                projected[found++] = {field, pos};
+            }
+            ++column;
+            if (pos == end || *pos == '\n') {
+                break;
+            }
+            field = pos + 1;
+        }
+        if (found == num_columns && pos != end && *pos != '\n') {
+            // At least one more field follows the last requested one.
+            size_t delimiters = 0;
+            pos = count_fields ? scanner.next_newline(delimiters) : scanner.next_newline();
+            column += delimiters + 1;
+        }
+        on_row(static_cast<const Field*>(projected), found, column, Field{line, pos});
+        line = (pos == end) ? end : pos + 1;
+    }
+}
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Returns true if the line holds nothing but whitespace.
+ */
+inline bool is_blank_line(Field line) {
+    for (const char* p = line.begin; p < line.end; ++p) {
+        if (!is_space(*p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes 1..8 ASCII digits with SWAR arithmetic (little-endian).
+ * @param p First digit.
+ * @param n Number of digits.
+ * @param out Receives the decoded value.
+ * @return false if any of the n bytes is not a digit.
+ */
+inline bool decode_digits8(const char* p, size_t n, uint64_t& out) {
+    // Left-pad with '0' so the digits occupy the low-order decimal places.
+    uint64_t chunk = 0x3030303030303030ULL;
+    std::memcpy(reinterpret_cast<char*>(&chunk) + (8 - n), p, n);
+    if (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+         (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL) {
+        return false;
+    }
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    out = chunk;
+    return true;
+}
+
+/**
+ * @brief Parses a field as a decimal integer, ignoring surrounding whitespace.
+ * @param f The field to parse.
+ * @param out Receives the parsed value.
+ * @return false if the field is not a well-formed integer.
+ */
+template <typename T>
+inline bool parse_field(Field f, T& out) {
+    const char* b = f.begin;
+    const char* e = f.end;
+    while (b < e && is_space(*b)) {
+        ++b;
+    }
+    while (e > b && is_space(e[-1])) {
+        --e;
+    }
+    bool negative = false;
+    if (b < e && (*b == '-' || *b == '+')) {
+        negative = (*b == '-');
+        ++b;
+    }
+    size_t n = static_cast<size_t>(e - b);
+    uint64_t value = 0;
+    if (n == 0) {
+        return false;
+    } else if (n <= 8) {
+        if (!decode_digits8(b, n, value)) {
+            return false;
+        }
+    } else if (n <= 16) {
+        uint64_t hi, lo;
+        if (!decode_digits8(b, n - 8, hi) || !decode_digits8(e - 8, 8, lo)) {
+            return false;
+        }
+        value = hi * 100000000ULL + lo;
+    } else {
+        for (; b < e; ++b) {
+            if (static_cast<unsigned>(*b - '0') >= 10u) {
+                return false;
+            }
+            value = value * 10 + static_cast<uint64_t>(*b - '0');
+        }
+    }
+    out = static_cast<T>(negative ? 0 - value : value);
+    return true;
+}
+
+#endif // CSV_SCAN_H
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+#include "column_store.h"
+#include "csv_scan.h"
+#include "fast_io.h"
+
+// Converts a CSV table (A.txt / B.txt style) into the binary columnar format
+// read by ColumnFile, so repeated benchmark runs can skip text parsing.
+//
+// Usage: ./csv_to_columnar <input.txt> <output.col> [type ...]
+//   One type per CSV column: i32, i64, p32 (bit-packed i32), or '-' to drop the column.
+//   Without types, every column of the first row is stored as i32.
+
+/**
+ * @brief Parses a column type name.
+ * @param name One of "i32", "i64", "p32" or "-".
+ * @param type Receives the type; unused for "-".
+ * @param keep Receives false for "-".
+ * @return false if the name is not recognised.
+ */
+bool parse_column_type(const std::string& name, ColumnType& type, bool& keep) {
+    keep = true;
+    if (name == "i32") {
+        type = ColumnType::Int32;
+    } else if (name == "i64") {
+        type = ColumnType::Int64;
+    } else if (name == "p32") {
+        type = ColumnType::PackedInt32;
+    } else if (name == "-") {
+        keep = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.col> [i32|i64|p32|- ...]" << std::endl;
+        return 1;
+    }
+    const std::string input_name = argv[1];
+    const std::string output_name = argv[2];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    MappedFile input(input_name);
+    if (!input.is_open()) {
+        std::cerr << "Error: Could not open file " << input_name << std::endl;
+        return 1;
+    }
+
+    // Column layout: from the command line, or one i32 column per field of the first row.
+    std::vector<ColumnType> types;
+    std::vector<bool> keep;
+    for (int i = 3; i < argc; ++i) {
+        ColumnType type = ColumnType::Int32;
+        bool keep_column = true;
+        if (!parse_column_type(argv[i], type, keep_column)) {
+            std::cerr << "Unknown column type: " << argv[i] << std::endl;
+            return 1;
+        }
+        types.push_back(type);
+        keep.push_back(keep_column);
+    }
+    size_t num_fields = types.size();
+    if (num_fields == 0) {
+        scan_rows(input.data(), input.end(), ',', [&](const Field*, size_t count, Field line) {
+            if (num_fields == 0 && !is_blank_line(line)) {
+                num_fields = count;
+            }
+        });
+        types.assign(num_fields, ColumnType::Int32);
+        keep.assign(num_fields, true);
+    }
+
+    std::vector<std::vector<int32_t>> int32_columns(num_fields);
+    std::vector<std::vector<int64_t>> int64_columns(num_fields);
+    uint64_t num_rows = 0;
+    uint64_t skipped = 0;
+    scan_rows(input.data(), input.end(), ',', [&](const Field* fields, size_t count, Field line) {
+        if (is_blank_line(line)) {
+            return;
+        }
+        int64_t values[kMaxFields];
+        bool valid = (count == num_fields && count <= kMaxFields);
+        for (size_t i = 0; valid && i < count; ++i) {
+            valid = !keep[i] || parse_field(fields[i], values[i]);
+        }
+        if (!valid) {
+            ++skipped;
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (!keep[i]) {
+                continue;
+            }
+            if (types[i] != ColumnType::Int64) {
+                int32_columns[i].push_back(static_cast<int32_t>(values[i]));
+            } else {
+                int64_columns[i].push_back(values[i]);
+            }
+        }
+        ++num_rows;
+    });
+
+    std::vector<ColumnData> columns;
+    for (size_t i = 0; i < num_fields; ++i) {
+        if (keep[i]) {
+            const void* data = (types[i] != ColumnType::Int64) ? static_cast<const void*>(int32_columns[i].data())
+                                                               : static_cast<const void*>(int64_columns[i].data());
+            columns.push_back({types[i], data});
+        }
+    }
+    if (!write_column_file(output_name, num_rows, columns)) {
+        return 1;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::cout << "Converted " << num_rows << " rows (" << columns.size() << " columns) from " << input_name
+              << " to " << output_name << " in " << duration.count() << " ms" << std::endl;
+    ColumnFile written;
+    if (written.open(output_name)) {
+        std::cout << "Size: " << input.size() << " bytes of text -> " << written.size_bytes() << " bytes" << std::endl;
+    }
+    if (skipped > 0) {
+        std::cout << "Skipped " << skipped << " malformed rows" << std::endl;
+    }
+    return 0;
+}
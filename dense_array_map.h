@@ -0,0 +1,152 @@
+#ifndef DENSE_ARRAY_MAP_H
+#define DENSE_ARRAY_MAP_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "table_stats.h"
+
+// -- Direct-addressed aggregation over a dense key domain --
+//
+// When the keys of a table span a small range, a group's slot can be found by
+// indexing an array with (key - min) instead of hashing. The loaders record each
+// table's KeyDomain while parsing; DenseArrayMap is then used in place of a hash
+// map whenever the domain fits the configured memory budget.
+
+/**
+ * @brief The [min, max] range of the keys seen in a table.
+ */
+struct KeyDomain {
+    int min = INT_MAX;
+    int max = INT_MIN;
+
+    void add(int key) {
+        min = std::min(min, key);
+        max = std::max(max, key);
+    }
+
+    void merge(const KeyDomain& other) {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    bool empty() const { return min > max; }
+
+    // Number of distinct key values the range can hold.
+    uint64_t size() const {
+        return empty() ? 0 : static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+    }
+};
+
+/**
+ * @brief Map from an int key within a fixed KeyDomain to a payload, stored as a plain array.
+ * Same interface as FlatHashMap; a presence bitmap tells inserted keys from untouched slots.
+ * @tparam Value Payload type; new entries start value-initialized.
+ */
+template <typename Value>
+class DenseArrayMap {
+public:
+    /**
+     * @brief Allocates one slot per key of domain.
+     */
+    explicit DenseArrayMap(const KeyDomain& domain)
+        : min_(domain.min),
+          slots_(domain.size()),
+          values_(new Value[slots_]()),
+          present_(new uint64_t[(slots_ + 63) / 64]()) {
+        TABLE_STATS(stats_.bytes_allocated = bytes_for(domain);)
+    }
+
+    DenseArrayMap(DenseArrayMap&&) = default;
+    DenseArrayMap& operator=(DenseArrayMap&&) = default;
+
+    /**
+     * @brief Bytes allocated by a map over domain.
+     */
+    static uint64_t bytes_for(const KeyDomain& domain) {
+        return domain.size() * sizeof(Value) + (domain.size() + 63) / 64 * sizeof(uint64_t);
+    }
+
+    /**
+     * @brief Returns the payload of key, marking it present. key must lie within the domain.
+     */
+    Value& operator[](int key) {
+        size_t i = index_of(key);
+        uint64_t bit = uint64_t(1) << (i % 64);
+        TABLE_STATS(stats_.record_probe(1, (present_[i / 64] & bit) != 0);)
+        if ((present_[i / 64] & bit) == 0) {
+            present_[i / 64] |= bit;
+            ++size_;
+        }
+        return values_[i];
+    }
+
+    /**
+     * @brief Returns a pointer to the payload of key, or nullptr if the key is absent or out of range.
+     */
+    Value* find(int key) {
+        size_t i = index_of(key);
+        if (i >= slots_ || (present_[i / 64] & (uint64_t(1) << (i % 64))) == 0) {
+            TABLE_STATS(stats_.record_probe(1, false);)
+            return nullptr;
+        }
+        TABLE_STATS(stats_.record_probe(1, true);)
+        return &values_[i];
+    }
+
+    /**
+     * @brief Starts loading the slot and presence word of key into cache; out-of-range keys are ignored.
+     */
+    void prefetch(int key) const {
+        size_t i = index_of(key);
+        if (i < slots_) {
+            __builtin_prefetch(&values_[i]);
+            __builtin_prefetch(&present_[i / 64]);
+        }
+    }
+
+    /**
+     * @brief Calls fn(int key, Value& value) for every present key, in ascending key order.
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) {
+        for (size_t word = 0; word < (slots_ + 63) / 64; ++word) {
+            for (uint64_t bits = present_[word]; bits != 0; bits &= bits - 1) {
+                size_t i = word * 64 + __builtin_ctzll(bits);
+                fn(static_cast<int>(min_ + static_cast<int64_t>(i)), values_[i]);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+
+#ifdef HASH_TABLE_STATS
+    /**
+     * @brief Lookup and allocation counters; every lookup has probe length 1.
+     */
+    TableStats stats() const {
+        TableStats stats = stats_;
+        stats.size = size_;
+        stats.capacity = slots_;
+        return stats;
+    }
+#endif
+
+private:
+    // Keys below min wrap around to large indices, so one comparison rejects both sides.
+    size_t index_of(int key) const {
+        return static_cast<size_t>(static_cast<int64_t>(key) - min_);
+    }
+
+    int64_t min_;
+    size_t slots_;
+    std::unique_ptr<Value[]> values_;
+    std::unique_ptr<uint64_t[]> present_;
+    size_t size_ = 0;
+    TABLE_STATS(mutable TableStats stats_;)
+};
+
+#endif // DENSE_ARRAY_MAP_H
@@ -0,0 +1,76 @@
+#ifndef EAGER_AGGREGATION_H
+#define EAGER_AGGREGATION_H
+
+#include <cstddef>
+#include <vector>
+
+#include "batched_probe.h"
+#include "flat_hash_map.h"
+
+// -- Eager aggregation: pushing SUM/COUNT below a join --
+//
+// The GroupJoin computes SUM(A.v) GROUP BY k as sum_in_a(k) * count_in_b(k),
+// which only covers grouping on the join key. The general rewrite handles
+//
+//   SELECT g, SUM(value_of_grouped + value_of_other)
+//   FROM grouped JOIN other ON grouped.k = other.k GROUP BY g
+//
+// where the grouping attribute g may be any column of one side (the "grouped"
+// side, e.g. B.g) or the join key, and the aggregated values may come from either
+// side (COUNT(*) is SUM(1)). The other side is first collapsed to one partial
+// aggregate per join key, {sum of its values, row count}. Each grouped row then
+// stands for count joined rows, so it adds
+//
+//   value_of_grouped(row) * count    (its own value, once per partner)
+//   + sum                            (every partner's value, once for this row)
+//
+// to its group: the multiplicity correction of each side is the other side's
+// count. No joined row is materialized. Groups spanning attributes of both
+// sides are not covered; they need per-(k, g) partials on both sides.
+
+/**
+ * @brief Partial aggregate of one side's rows that share a join key.
+ */
+struct KeyAggregate {
+    long long sum;    // SUM of the side's aggregated values
+    long long count;  // Number of rows
+};
+
+/**
+ * @brief Computes SUM(value_of_grouped + value_of_other) GROUP BY group_of over grouped JOIN other.
+ * @param grouped The side that holds the grouping attribute; it probes the other side's partials.
+ * @param other The side collapsed to one KeyAggregate per join key.
+ * @param key_of_grouped, key_of_other Callables (const Row&) -> int, the join keys.
+ * @param group_of Callable (const RowG&) -> int, the grouping attribute.
+ * @param value_of_grouped, value_of_other Callables (const Row&) -> long long; return 0 for a
+ *        side that contributes no aggregated column, and 1 on one side for COUNT(*).
+ * @param emit Callable (int group, long long sum), called once per group that joined.
+ * @param probe_batch Grouped keys prefetched at a time; 1 disables prefetching.
+ */
+template <typename RowG, typename RowO, typename KeyOfG, typename KeyOfO, typename GroupFn, typename ValueOfG, typename ValueOfO,
+          typename EmitFn>
+void eager_aggregate_join(const std::vector<RowG>& grouped, const std::vector<RowO>& other, KeyOfG key_of_grouped,
+                          KeyOfO key_of_other, GroupFn group_of, ValueOfG value_of_grouped, ValueOfO value_of_other,
+                          EmitFn emit, size_t probe_batch = kDefaultProbeBatch) {
+    // 1. Pre-aggregate the other side per join key.
+    FlatHashMap<int, KeyAggregate> partials;
+    for (const auto& row : other) {
+        KeyAggregate& partial = partials[key_of_other(row)];
+        partial.sum += value_of_other(row);
+        partial.count++;
+    }
+
+    // 2. Probe with the grouped side; each match adds its rows' corrected contributions to the group.
+    FlatHashMap<int, long long> groups;
+    probe_batched(partials, grouped.data(), grouped.size(), probe_batch, key_of_grouped, [&](const RowG& row) {
+        if (const KeyAggregate* partial = partials.find(key_of_grouped(row))) {
+            groups[group_of(row)] += value_of_grouped(row) * partial->count + partial->sum;
+        }
+    });
+
+    TABLE_STATS(partials.stats().print("eager_aggregate_join partials");)
+    TABLE_STATS(groups.stats().print("eager_aggregate_join groups");)
+    groups.for_each([&](int group, long long sum) { emit(group, sum); });
+}
+
+#endif // EAGER_AGGREGATION_H
@@ -0,0 +1,417 @@
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -- Zero-copy file access --
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * The mapping is released when the object goes out of scope.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename) { open(filename); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the given file into memory.
+     * @param filename The name of the file to map.
+     * @return true on success (an empty file maps successfully to size 0).
+     */
+    bool open(const std::string& filename) {
+        close();
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) {
+            return true;
+        }
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (addr == MAP_FAILED) {
+            close();
+            return false;
+        }
+        // The loaders walk the file front to back exactly once.
+        ::madvise(addr, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(addr);
+        return true;
+    }
+
+    void close() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        size_ = 0;
+    }
+
+    bool is_open() const { return fd_ >= 0; }
+    const char* data() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+
+private:
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Bytes consumed and wall time spent by a table loader.
+ */
+struct LoadStats {
+    size_t bytes = 0;
+    double millis = 0.0;
+
+    double gb_per_s() const {
+        return millis > 0.0 ? (bytes / 1e9) / (millis / 1e3) : 0.0;
+    }
+};
+
+// -- Parallel chunked ingestion --
+
+/**
+ * @brief Splits a buffer into at most `parts` byte ranges that each end on a line boundary.
+ * @param data Start of the buffer.
+ * @param size Size of the buffer in bytes.
+ * @param parts Requested number of ranges.
+ * @return Non-empty [begin, end) ranges covering the whole buffer in order.
+ */
+inline std::vector<std::pair<const char*, const char*>> split_at_newlines(const char* data, size_t size, int parts) {
+    std::vector<std::pair<const char*, const char*>> ranges;
+    const char* end = data + size;
+    const char* begin = data;
+    for (int i = 1; i <= parts && begin < end; ++i) {
+        const char* cut = (i == parts) ? end : data + size / parts * i;
+        if (cut < begin) {
+            cut = begin;
+        }
+        // Move the cut just past the next newline so no line is split between ranges.
+        if (cut < end) {
+            const char* nl = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+            cut = (nl == nullptr) ? end : nl + 1;
+        }
+        if (cut > begin) {
+            ranges.emplace_back(begin, cut);
+            begin = cut;
+        }
+    }
+    return ranges;
+}
+
+/**
+ * @brief Parses a buffer on several threads and concatenates the rows in file order.
+ * Each thread fills its own row buffer; the buffers are then copied into the
+ * final table at offsets given by a prefix sum over their sizes.
+ * @param data Start of the buffer.
+ * @param size Size of the buffer in bytes.
+ * @param num_threads Number of parser threads (1 parses on the calling thread).
+ * @param parse_range Callable (const char* begin, const char* end, std::vector<Row>& out).
+ * @return All parsed rows.
+ */
+template <typename Row, typename RangeParser>
+std::vector<Row> parallel_parse(const char* data, size_t size, int num_threads, RangeParser parse_range) {
+    std::vector<Row> table;
+    if (num_threads <= 1) {
+        parse_range(data, data + size, table);
+        return table;
+    }
+
+    auto ranges = split_at_newlines(data, size, num_threads);
+    std::vector<std::vector<Row>> local(ranges.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        workers.emplace_back([&, i] { parse_range(ranges[i].first, ranges[i].second, local[i]); });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    workers.clear();
+
+    std::vector<size_t> offsets(local.size() + 1, 0);
+    for (size_t i = 0; i < local.size(); ++i) {
+        offsets[i + 1] = offsets[i] + local[i].size();
+    }
+    table.resize(offsets.back());
+    for (size_t i = 0; i < local.size(); ++i) {
+        workers.emplace_back([&, i] {
+            std::copy(local[i].begin(), local[i].end(), table.begin() + offsets[i]);
+            std::vector<Row>().swap(local[i]);
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    return table;
+}
+
+/**
+ * @brief Default parser thread count: one per hardware thread.
+ */
+inline int default_thread_count() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : static_cast<int>(n);
+}
+
+// -- Streaming input --
+
+/**
+ * @brief Reads a file in fixed-size chunks on background threads, ahead of the consumer.
+ * Up to `depth` chunk buffers are in flight at once: while the caller parses one
+ * chunk, the I/O threads pread the following ones, so disk reads overlap parsing.
+ * Chunks are handed out strictly in file order.
+ */
+class AsyncFileReader {
+public:
+    /**
+     * @param filename The name of the file to read.
+     * @param chunk_size Size of each read in bytes.
+     * @param depth Number of chunk buffers (1 disables read-ahead).
+     * @param io_threads Number of threads issuing pread calls.
+     */
+    AsyncFileReader(const std::string& filename, size_t chunk_size, int depth, int io_threads)
+        : chunk_size_(std::max<size_t>(chunk_size, 64)), slots_(static_cast<size_t>(std::max(depth, 1))) {
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+            return;
+        }
+        file_size_ = static_cast<size_t>(st.st_size);
+        num_chunks_ = (file_size_ + chunk_size_ - 1) / chunk_size_;
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (auto& slot : slots_) {
+            slot.buffer.resize(chunk_size_);
+        }
+        for (int i = 0; i < std::max(io_threads, 1); ++i) {
+            io_threads_.emplace_back([this] { io_loop(); });
+        }
+    }
+
+    ~AsyncFileReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : io_threads_) {
+            t.join();
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    bool failed() const { return failed_; }
+    size_t file_size() const { return file_size_; }
+
+    /**
+     * @brief Waits for the next chunk in file order. The previous chunk is released.
+     * @param data Receives the start of the chunk.
+     * @param size Receives the chunk size in bytes.
+     * @return false at end of file or after a read error.
+     */
+    bool next(const char*& data, size_t& size) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (holding_) {
+            slots_[released_ % slots_.size()].ready = false;
+            ++released_;
+            holding_ = false;
+            cv_.notify_all();
+        }
+        if (released_ == num_chunks_) {
+            return false;
+        }
+        Slot& slot = slots_[released_ % slots_.size()];
+        cv_.wait(lock, [&] { return failed_ || (slot.ready && slot.chunk == released_); });
+        if (failed_) {
+            return false;
+        }
+        data = slot.buffer.data();
+        size = slot.size;
+        holding_ = true;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::vector<char> buffer;
+        size_t chunk = 0;
+        size_t size = 0;
+        bool ready = false;
+    };
+
+    void io_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            // A chunk may be issued once the chunk that last used its slot has been released.
+            cv_.wait(lock, [&] {
+                return stop_ || failed_ || (next_to_issue_ < num_chunks_ && next_to_issue_ < released_ + slots_.size());
+            });
+            if (stop_ || failed_) {
+                return;
+            }
+            size_t chunk = next_to_issue_++;
+            Slot& slot = slots_[chunk % slots_.size()];
+            lock.unlock();
+
+            size_t offset = chunk * chunk_size_;
+            size_t want = std::min(chunk_size_, file_size_ - offset);
+            size_t got = 0;
+            bool ok = true;
+            while (got < want) {
+                ssize_t n = ::pread(fd_, slot.buffer.data() + got, want - got, static_cast<off_t>(offset + got));
+                if (n <= 0) {
+                    ok = false;
+                    break;
+                }
+                got += static_cast<size_t>(n);
+            }
+
+            lock.lock();
+            if (!ok) {
+                failed_ = true;
+            } else {
+                slot.chunk = chunk;
+                slot.size = got;
+                slot.ready = true;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    int fd_ = -1;
+    size_t file_size_ = 0;
+    size_t chunk_size_;
+    size_t num_chunks_ = 0;
+    std::vector<Slot> slots_;
+    std::vector<std::thread> io_threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t next_to_issue_ = 0;
+    size_t released_ = 0;
+    bool holding_ = false;
+    bool failed_ = false;
+    bool stop_ = false;
+};
+
+/**
+ * @brief Reads a file through fixed-size buffers and hands out ranges of whole lines.
+ * Reads are issued ahead of the caller by an AsyncFileReader. A line cut off at the
+ * end of one chunk is stitched with the start of the next, so every range passed to
+ * on_range starts at the beginning of a line and ends after a '\n' (or at end of
+ * file). Memory use is bounded by io_depth * buffer_size.
+ * @param filename The name of the file to read.
+ * @param buffer_size Size of each read buffer in bytes.
+ * @param on_range Callable (const char* begin, const char* end).
+ * @param bytes_read Optional; receives the number of bytes read.
+ * @param io_depth Number of buffers kept in flight ahead of the parser.
+ * @return false if the file could not be opened or read; after a read failure the
+ *         partial line left at the end is not passed to on_range.
+ */
+template <typename RangeFn>
+bool for_each_line_chunk(const std::string& filename, size_t buffer_size, RangeFn on_range,
+                         size_t* bytes_read = nullptr, int io_depth = 4) {
+    AsyncFileReader reader(filename, buffer_size, io_depth, std::min(io_depth, 2));
+    if (!reader.is_open()) {
+        return false;
+    }
+
+    std::string carry; // Partial line left over from the previous chunk
+    const char* data;
+    size_t size;
+    while (reader.next(data, size)) {
+        const char* p = data;
+        const char* end = data + size;
+        if (!carry.empty()) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', size));
+            if (nl == nullptr) {
+                carry.append(p, size);
+                continue;
+            }
+            carry.append(p, nl + 1);
+            on_range(carry.data(), carry.data() + carry.size());
+            carry.clear();
+            p = nl + 1;
+        }
+        const char* last_newline = static_cast<const char*>(::memrchr(p, '\n', end - p));
+        if (last_newline == nullptr) {
+            carry.append(p, end);
+            continue;
+        }
+        on_range(p, last_newline + 1);
+        carry.append(last_newline + 1, end);
+    }
+    if (reader.failed()) {
+        return false; // carry may be a line cut short by the failed read
+    }
+    if (!carry.empty()) {
+        on_range(carry.data(), carry.data() + carry.size());
+    }
+    if (bytes_read != nullptr) {
+        *bytes_read = reader.file_size();
+    }
+    return true;
+}
+
+/**
+ * @brief Evicts a file from the OS page cache so the next read comes from disk.
+ * @return false if the file could not be opened or the hint was rejected.
+ */
+inline bool drop_file_cache(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief How a table loader reads its input.
+ */
+struct LoadOptions {
+    int num_threads = 1;          // Parser threads for the mmap path
+    bool async_io = false;        // Read through AsyncFileReader instead of mmap
+    size_t buffer_size = 1 << 20; // Bytes per read buffer on the async path
+    int io_depth = 4;             // Buffers kept in flight ahead of the parser
+};
+
+#endif // FAST_IO_H
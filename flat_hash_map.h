@@ -0,0 +1,220 @@
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "hash_policy.h"
+#include "table_stats.h"
+
+// -- Open-addressing hash map for integer keys --
+//
+// Keys and payloads live in two flat arrays of power-of-two capacity and
+// collisions are resolved by linear probing, so an insert never allocates a
+// node and a lookup touches one or two cache lines instead of chasing a bucket
+// list. A reserved key value (EmptyKey) marks free slots; the map still accepts
+// that key, storing it in a dedicated slot outside the arrays.
+
+/**
+ * @brief Hash map from an integer key to a default-constructible payload.
+ * @tparam Key Integer key type.
+ * @tparam Value Payload type; new entries start value-initialized (zero for arithmetic types).
+ * @tparam EmptyKey Key value that marks a free slot.
+ * @tparam Hash Hash policy (see hash_policy.h); slots are picked from its high bits.
+ */
+template <typename Key, typename Value, Key EmptyKey = std::numeric_limits<Key>::min(), typename Hash = MultiplyShiftHash>
+class FlatHashMap {
+    static_assert(std::is_integral<Key>::value, "FlatHashMap keys are integers");
+
+public:
+    /**
+     * @brief Creates a map sized to hold expected_size keys without rehashing.
+     */
+    explicit FlatHashMap(size_t expected_size = 0) { rehash(capacity_for(expected_size)); }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+    FlatHashMap(FlatHashMap&&) = default;
+    FlatHashMap& operator=(FlatHashMap&&) = default;
+
+    /**
+     * @brief Returns the payload of key, inserting a value-initialized one if it is missing.
+     */
+    Value& operator[](Key key) {
+        if (key == EmptyKey) {
+            TABLE_STATS(stats_.record_probe(1, has_empty_key_);)
+            if (!has_empty_key_) {
+                has_empty_key_ = true;
+                empty_key_value_ = Value();
+                ++size_;
+            }
+            return empty_key_value_;
+        }
+        if ((size_ + 1) * 4 > capacity_ * 3) {
+            rehash(capacity_ * 2);
+        }
+        size_t slot = home_slot(key);
+        while (keys_[slot] != key) {
+            if (keys_[slot] == EmptyKey) {
+                keys_[slot] = key;
+                ++size_;
+                TABLE_STATS(record_probe(key, slot, false);)
+                return values_[slot];
+            }
+            slot = (slot + 1) & mask_;
+        }
+        TABLE_STATS(record_probe(key, slot, true);)
+        return values_[slot];
+    }
+
+    /**
+     * @brief Returns a pointer to the payload of key, or nullptr if the key is absent.
+     */
+    Value* find(Key key) {
+        if (key == EmptyKey) {
+            TABLE_STATS(stats_.record_probe(1, has_empty_key_);)
+            return has_empty_key_ ? &empty_key_value_ : nullptr;
+        }
+        size_t slot = home_slot(key);
+        while (keys_[slot] != key) {
+            if (keys_[slot] == EmptyKey) {
+                TABLE_STATS(record_probe(key, slot, false);)
+                return nullptr;
+            }
+            slot = (slot + 1) & mask_;
+        }
+        TABLE_STATS(record_probe(key, slot, true);)
+        return &values_[slot];
+    }
+
+    const Value* find(Key key) const {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    /**
+     * @brief Returns the number of slots a lookup of key examines (hits and misses alike).
+     */
+    size_t probe_length(Key key) const {
+        if (key == EmptyKey) {
+            return 1;
+        }
+        size_t length = 1;
+        for (size_t slot = home_slot(key); keys_[slot] != key && keys_[slot] != EmptyKey; slot = (slot + 1) & mask_) {
+            ++length;
+        }
+        return length;
+    }
+
+    /**
+     * @brief Starts loading the home slot of key into cache ahead of a find or insert.
+     */
+    void prefetch(Key key) const {
+        size_t slot = home_slot(key);
+        __builtin_prefetch(&keys_[slot]);
+        __builtin_prefetch(&values_[slot]);
+    }
+
+    /**
+     * @brief Calls fn(Key key, Value& value) for every entry, in unspecified order.
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) {
+        if (has_empty_key_) {
+            fn(EmptyKey, empty_key_value_);
+        }
+        for (size_t slot = 0; slot < capacity_; ++slot) {
+            if (keys_[slot] != EmptyKey) {
+                fn(keys_[slot], values_[slot]);
+            }
+        }
+    }
+
+    /**
+     * @brief Grows the table so that expected_size keys fit without rehashing.
+     */
+    void reserve(size_t expected_size) {
+        size_t capacity = capacity_for(expected_size);
+        if (capacity > capacity_) {
+            rehash(capacity);
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+#ifdef HASH_TABLE_STATS
+    /**
+     * @brief Lookup and allocation counters; operator[] counts as a lookup.
+     */
+    TableStats stats() const {
+        TableStats stats = stats_;
+        stats.size = size_;
+        stats.capacity = capacity_;
+        return stats;
+    }
+#endif
+
+private:
+#ifdef HASH_TABLE_STATS
+    // Records a lookup of key that ended at slot.
+    void record_probe(Key key, size_t slot, bool hit) const {
+        stats_.record_probe(((slot - home_slot(key)) & mask_) + 1, hit);
+    }
+#endif
+
+    // Smallest power of two that keeps expected_size keys under the 3/4 load limit.
+    static size_t capacity_for(size_t expected_size) {
+        size_t capacity = 16;
+        while (capacity * 3 < expected_size * 4) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    // The high bits of the hash pick the slot.
+    size_t home_slot(Key key) const {
+        return static_cast<size_t>(Hash::hash(static_cast<uint64_t>(key)) >> shift_);
+    }
+
+    void rehash(size_t new_capacity) {
+        std::unique_ptr<Key[]> old_keys = std::move(keys_);
+        std::unique_ptr<Value[]> old_values = std::move(values_);
+        size_t old_capacity = capacity_;
+        TABLE_STATS(stats_.resizes += size_ != 0 ? 1 : 0;)
+        TABLE_STATS(stats_.bytes_allocated = new_capacity * (sizeof(Key) + sizeof(Value));)
+
+        capacity_ = new_capacity;
+        mask_ = new_capacity - 1;
+        shift_ = 64 - __builtin_ctzll(new_capacity);
+        keys_.reset(new Key[new_capacity]);
+        values_.reset(new Value[new_capacity]());
+        for (size_t slot = 0; slot < new_capacity; ++slot) {
+            keys_[slot] = EmptyKey;
+        }
+        for (size_t slot = 0; slot < old_capacity; ++slot) {
+            if (old_keys[slot] != EmptyKey) {
+                size_t target = home_slot(old_keys[slot]);
+                while (keys_[target] != EmptyKey) {
+                    target = (target + 1) & mask_;
+                }
+                keys_[target] = old_keys[slot];
+                values_[target] = old_values[slot];
+            }
+        }
+    }
+
+    std::unique_ptr<Key[]> keys_;
+    std::unique_ptr<Value[]> values_;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    unsigned shift_ = 64;
+    size_t size_ = 0;
+    bool has_empty_key_ = false;
+    Value empty_key_value_ = Value();
+    TABLE_STATS(mutable TableStats stats_;)
+};
+
+#endif // FLAT_HASH_MAP_H
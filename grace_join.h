@@ -0,0 +1,395 @@
+#ifndef GRACE_JOIN_H
+#define GRACE_JOIN_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "radix_partition.h"
+
+// -- Out-of-core (Grace) hash join under a memory budget --
+//
+// The in-memory joins need A, its hash table and their output resident at once.
+// grace_join streams A and keeps it in memory only while its build side (rows
+// plus the caller's join and aggregation tables, build_row_bytes per row) fits
+// the budget. Once it would not, A and then B are hash-partitioned into
+// 2^kGraceBitsPerLevel temporary files each, by the same bits of radix_hash(k),
+// and the partition pairs are joined one at a time: the A partition is read
+// back and built, the B partition streamed through the probe in chunks. A
+// partition whose build side still exceeds the budget is split again by the
+// next hash bits, up to kGraceMaxLevels levels; one that cannot shrink (a
+// single key's rows exceed the budget) is joined over budget and counted.
+// Partitions cover disjoint keys, so each one's groups are final when it ends.
+// Spill files are unlinked as soon as they are created and vanish on exit.
+
+constexpr int kGraceBitsPerLevel = 6;
+constexpr int kGraceMaxLevels = 3;
+constexpr size_t kGraceSpillBufferBytes = size_t(256) << 10;  // Write buffer per spill file, at most
+constexpr size_t kGraceProbeChunkRows = size_t(64) << 10;     // B rows probed per call
+
+/**
+ * @brief How grace_join may use memory and disk.
+ */
+struct GraceJoinOptions {
+    uint64_t memory_budget = uint64_t(1) << 30;  // Bytes for one partition's build side
+    size_t build_row_bytes = 0;                  // Bytes per build row: the row and its share of the caller's tables
+    std::string spill_dir = ".";                 // Where the temporary partition files go
+};
+
+/**
+ * @brief What grace_join did.
+ */
+struct GraceJoinStats {
+    size_t partitions_joined = 0;  // Partition pairs built and probed (1 if nothing spilled)
+    size_t repartitioned = 0;      // Partitions split again because their build side exceeded the budget
+    size_t over_budget = 0;        // Partitions joined over budget because splitting did not shrink them
+    int levels = 0;                // Partitioning levels used; 0 if A fit the budget
+    uint64_t bytes_spilled = 0;    // Bytes written to spill files, over all levels
+    uint64_t peak_build_bytes = 0; // Bytes of the largest build side joined (rows * build_row_bytes)
+};
+
+/**
+ * @brief An anonymous temporary file of fixed-size rows, appended through a buffer and read back in chunks.
+ */
+template <typename Row>
+class SpillFile {
+public:
+    SpillFile() = default;
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+    ~SpillFile() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    /**
+     * @brief Creates the file in dir and unlinks it, so it is removed once closed.
+     * @param buffer_rows Rows buffered before each write.
+     * @return false if the file could not be created.
+     */
+    bool open(const std::string& dir, size_t buffer_rows) {
+        std::string path = dir + "/grace_spill_XXXXXX";
+        fd_ = ::mkstemp(&path[0]);
+        if (fd_ < 0) {
+            return false;
+        }
+        ::unlink(path.c_str());
+        buffer_rows_ = std::max<size_t>(1, buffer_rows);
+        return true;
+    }
+
+    void append(const Row& row) {
+        if (buffer_.empty()) {
+            buffer_.reserve(buffer_rows_);  // Exactly the buffer's share of the budget, not a doubling of it
+        }
+        buffer_.push_back(row);
+        if (buffer_.size() >= buffer_rows_) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief Writes the buffered rows and releases the buffer.
+     */
+    void flush() {
+        write_all(buffer_.data(), buffer_.size() * sizeof(Row));
+        written_rows_ += buffer_.size();
+        std::vector<Row>().swap(buffer_);
+    }
+
+    size_t rows() const { return written_rows_ + buffer_.size(); }
+    uint64_t bytes() const { return static_cast<uint64_t>(rows()) * sizeof(Row); }
+    bool failed() const { return failed_; }
+
+    /**
+     * @brief Flushes, then calls fn(const Row* rows, size_t count) over the file, chunk_rows at a time.
+     * @return false on a read or write error.
+     */
+    template <typename ChunkFn>
+    bool for_each_chunk(size_t chunk_rows, ChunkFn fn) {
+        flush();
+        std::unique_ptr<Row[]> chunk(new Row[chunk_rows]);
+        for (size_t offset = 0; offset < written_rows_ && !failed_; offset += chunk_rows) {
+            size_t count = std::min(chunk_rows, written_rows_ - offset);
+            if (!read_all(chunk.get(), count * sizeof(Row), static_cast<off_t>(offset * sizeof(Row)))) {
+                break;
+            }
+            fn(chunk.get(), count);
+        }
+        return !failed_;
+    }
+
+    /**
+     * @brief Flushes, then reads the whole file into rows.
+     * @return false on a read or write error.
+     */
+    bool read_rows(std::vector<Row>& rows) {
+        flush();
+        rows.resize(written_rows_);
+        return !failed_ && read_all(rows.data(), written_rows_ * sizeof(Row), 0);
+    }
+
+private:
+    void write_all(const Row* rows, size_t bytes) {
+        const char* p = reinterpret_cast<const char*>(rows);
+        while (bytes > 0 && !failed_) {
+            ssize_t n = ::write(fd_, p, bytes);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed_ = true;
+                break;
+            }
+            p += n;
+            bytes -= static_cast<size_t>(n);
+        }
+    }
+
+    bool read_all(Row* rows, size_t bytes, off_t offset) {
+        char* p = reinterpret_cast<char*>(rows);
+        while (bytes > 0) {
+            ssize_t n = ::pread(fd_, p, bytes, offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed_ = true;
+                return false;
+            }
+            p += n;
+            offset += n;
+            bytes -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int fd_ = -1;
+    size_t buffer_rows_ = 1;
+    size_t written_rows_ = 0;
+    std::vector<Row> buffer_;
+    bool failed_ = false;
+};
+
+template <typename Row>
+using SpillPartitions = std::vector<std::unique_ptr<SpillFile<Row>>>;
+
+/**
+ * @brief Partition of key at a partitioning level (0 = first): the level's bits of radix_hash(key).
+ */
+inline size_t grace_partition_of(int key, int level) {
+    const int shift = 64 - kGraceBitsPerLevel * (level + 1);
+    return static_cast<size_t>((radix_hash(key) >> shift) & ((uint64_t(1) << kGraceBitsPerLevel) - 1));
+}
+
+/**
+ * @brief Opens one spill file per partition, with write buffers that together take at most an
+ * eighth of the budget.
+ * @return false (after reporting it) if a file could not be created.
+ */
+template <typename Row>
+bool open_spill_partitions(SpillPartitions<Row>& parts, const GraceJoinOptions& options) {
+    const size_t fanout = size_t(1) << kGraceBitsPerLevel;
+    size_t buffer_bytes = std::min<uint64_t>(kGraceSpillBufferBytes, options.memory_budget / 8 / fanout);
+    parts.clear();
+    for (size_t p = 0; p < fanout; ++p) {
+        parts.emplace_back(new SpillFile<Row>());
+        if (!parts.back()->open(options.spill_dir, buffer_bytes / sizeof(Row))) {
+            std::cerr << "Error: Could not create a spill file in " << options.spill_dir << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Flushes every partition and adds its bytes to the spill total.
+ * @return false (after reporting it) if a write failed.
+ */
+template <typename Row>
+bool flush_spill_partitions(SpillPartitions<Row>& parts, GraceJoinStats& stats) {
+    for (auto& part : parts) {
+        part->flush();
+        stats.bytes_spilled += part->bytes();
+        if (part->failed()) {
+            std::cerr << "Error: Could not write a spill file" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Joins one spilled partition pair, splitting it again first if A's side exceeds the budget.
+ * @param level The partitioning level that produced the pair (0 = first).
+ * @see grace_join for the callables.
+ */
+template <typename RowA, typename RowB, typename BuildFn, typename ProbeFn, typename FinishFn>
+bool grace_join_partition(SpillFile<RowA>& part_a, SpillFile<RowB>& part_b, int level, const GraceJoinOptions& options,
+                          BuildFn& build, ProbeFn& probe, FinishFn& finish, GraceJoinStats& stats) {
+    if (part_a.rows() == 0 || part_b.rows() == 0) {
+        return true;  // No key of this partition can join.
+    }
+    const uint64_t build_bytes = static_cast<uint64_t>(part_a.rows()) * options.build_row_bytes;
+    if (build_bytes > options.memory_budget && level + 1 < kGraceMaxLevels) {
+        // Split both sides by the next hash bits; if A lands in one child, its keys are too few to split.
+        SpillPartitions<RowA> children_a;
+        SpillPartitions<RowB> children_b;
+        if (!open_spill_partitions(children_a, options) || !open_spill_partitions(children_b, options)) {
+            return false;
+        }
+        bool ok = part_a.for_each_chunk(kGraceProbeChunkRows, [&](const RowA* rows, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                children_a[grace_partition_of(rows[i].k, level + 1)]->append(rows[i]);
+            }
+        });
+        ok = ok && part_b.for_each_chunk(kGraceProbeChunkRows, [&](const RowB* rows, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                children_b[grace_partition_of(rows[i].k, level + 1)]->append(rows[i]);
+            }
+        });
+        if (!ok) {
+            std::cerr << "Error: Could not read a spill file" << std::endl;
+            return false;
+        }
+        if (!flush_spill_partitions(children_a, stats) || !flush_spill_partitions(children_b, stats)) {
+            return false;
+        }
+        bool split = std::none_of(children_a.begin(), children_a.end(),
+                                  [&](const auto& child) { return child->rows() == part_a.rows(); });
+        if (split) {
+            ++stats.repartitioned;
+            stats.levels = std::max(stats.levels, level + 2);
+            for (size_t p = 0; p < children_a.size(); ++p) {
+                if (!grace_join_partition(*children_a[p], *children_b[p], level + 1, options, build, probe, finish, stats)) {
+                    return false;
+                }
+                children_a[p].reset();
+                children_b[p].reset();
+            }
+            return true;
+        }
+    }
+    if (build_bytes > options.memory_budget) {
+        ++stats.over_budget;
+    }
+
+    std::vector<RowA> rows_a;
+    if (!part_a.read_rows(rows_a)) {
+        std::cerr << "Error: Could not read a spill file" << std::endl;
+        return false;
+    }
+    build(rows_a.data(), rows_a.size());
+    std::vector<RowA>().swap(rows_a);
+    if (!part_b.for_each_chunk(kGraceProbeChunkRows, probe)) {
+        std::cerr << "Error: Could not read a spill file" << std::endl;
+        return false;
+    }
+    finish();
+    ++stats.partitions_joined;
+    stats.peak_build_bytes = std::max(stats.peak_build_bytes, build_bytes);
+    return true;
+}
+
+/**
+ * @brief Joins A and B under a memory budget, spilling hash partitions of both to disk when A's
+ * build side would not fit.
+ * @tparam RowA, RowB Trivially copyable rows whose join key is the member k.
+ * @param scan_a, scan_b Callables (on_row) that stream every row of their table to
+ *        on_row(const Row&) and return false if the table could not be read.
+ * @param options The budget, the build bytes per A row and the spill directory.
+ * @param build Callable (const RowA* rows, size_t count): builds the join over one partition's
+ *        A rows; the rows are released afterwards.
+ * @param probe Callable (const RowB* rows, size_t count): probes the current build with B rows;
+ *        called once per chunk of the partition.
+ * @param finish Callable (): emits the current partition's groups and releases its tables.
+ * @param stats Receives what was spilled and joined.
+ * @return false if an input or a spill file could not be read or written.
+ */
+template <typename RowA, typename RowB, typename ScanA, typename ScanB, typename BuildFn, typename ProbeFn, typename FinishFn>
+bool grace_join(ScanA scan_a, ScanB scan_b, const GraceJoinOptions& options, BuildFn build, ProbeFn probe, FinishFn finish,
+                GraceJoinStats& stats) {
+    stats = GraceJoinStats();
+    const size_t budget_rows = static_cast<size_t>(std::max<uint64_t>(1, options.memory_budget / std::max<size_t>(1, options.build_row_bytes)));
+
+    // 1. Stream A into memory until its build side would exceed the budget, then into partitions.
+    //    Reserved up front: growing by doubling could briefly hold twice the budgeted rows.
+    std::vector<RowA> rows_a;
+    rows_a.reserve(budget_rows + 1);
+    SpillPartitions<RowA> parts_a;
+    bool spill_failed = false;
+    bool ok = scan_a([&](const RowA& row) {
+        if (!parts_a.empty()) {
+            parts_a[grace_partition_of(row.k, 0)]->append(row);
+            return;
+        }
+        rows_a.push_back(row);
+        if (rows_a.size() > budget_rows && !spill_failed) {
+            if (!open_spill_partitions(parts_a, options)) {
+                spill_failed = true;
+                parts_a.clear();
+                return;
+            }
+            for (const RowA& buffered : rows_a) {
+                parts_a[grace_partition_of(buffered.k, 0)]->append(buffered);
+            }
+            std::vector<RowA>().swap(rows_a);
+        }
+    });
+    if (!ok || spill_failed) {
+        return false;
+    }
+
+    // 2a. A fits: build it once and stream B through the probe in chunks.
+    std::vector<RowB> chunk_b;
+    chunk_b.reserve(kGraceProbeChunkRows);
+    if (parts_a.empty()) {
+        build(rows_a.data(), rows_a.size());
+        stats.peak_build_bytes = static_cast<uint64_t>(rows_a.size()) * options.build_row_bytes;
+        std::vector<RowA>().swap(rows_a);
+        ok = scan_b([&](const RowB& row) {
+            chunk_b.push_back(row);
+            if (chunk_b.size() == kGraceProbeChunkRows) {
+                probe(chunk_b.data(), chunk_b.size());
+                chunk_b.clear();
+            }
+        });
+        probe(chunk_b.data(), chunk_b.size());
+        finish();
+        stats.partitions_joined = 1;
+        return ok;
+    }
+
+    // 2b. A spilled: partition B the same way, then join the pairs one at a time.
+    if (!flush_spill_partitions(parts_a, stats)) {
+        return false;
+    }
+    SpillPartitions<RowB> parts_b;
+    if (!open_spill_partitions(parts_b, options)) {
+        return false;
+    }
+    ok = scan_b([&](const RowB& row) { parts_b[grace_partition_of(row.k, 0)]->append(row); });
+    if (!ok || !flush_spill_partitions(parts_b, stats)) {
+        return false;
+    }
+    stats.levels = 1;
+    for (size_t p = 0; p < parts_a.size(); ++p) {
+        if (!grace_join_partition(*parts_a[p], *parts_b[p], 0, options, build, probe, finish, stats)) {
+            return false;
+        }
+        parts_a[p].reset();
+        parts_b[p].reset();
+    }
+    return true;
+}
+
+#endif // GRACE_JOIN_H
@@ -1,109 +1,95 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <chrono>
 #include <algorithm> // Required for std::sort
 
+#include "csv_scan.h"
+#include "fast_io.h"
+#include "flat_hash_map.h"
+#include "table_schema.h"
+
+// Represents the columns read from a row of table A (k, v, ...)
+struct RowA {
+    int k;
+    int v;
+};
+
+// Represents the column read from a row of table B (_, k, ...)
+struct RowB {
+    int k;
+};
+
+// Text layouts: A has 4 columns with k, v first; B has 5 columns with k second
+using SchemaA = TableSchema<RowA, 4, ',', Column<0, &RowA::k>, Column<1, &RowA::v>>;
+using SchemaB = TableSchema<RowB, 5, ',', Column<1, &RowB::k>>;
+
 // Represents a final aggregated result row
 struct AggregatedResult {
     int k;
     long long sum_v; // Use long long to handle potentially large sums
 };
 
-// -- Helper Functions --
-
-/**
- * @brief Parses a CSV string and returns a vector of strings.
- * @param line The string line to parse.
- * @param delimiter The character to split the string by.
- * @return A vector of string tokens.
- */
-std::vector<std::string> parse_csv_line(const std::string& line, char delimiter = ',') {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(line);
-    while (std::getline(tokenStream, token, delimiter)) {
-        // Trim leading/trailing whitespace
-        size_t first = token.find_first_not_of(" \t\n\r");
-        if (std::string::npos == first) {
-            tokens.push_back("");
-            continue;
-        }
-        size_t last = token.find_last_not_of(" \t\n\r");
-        tokens.push_back(token.substr(first, (last - first + 1)));
-    }
-    return tokens;
-}
+// Aggregate slot of one A group in the GroupJoin hash table
+struct GroupJoinSlot {
+    long long sum_v;   // SUM(A.v) over the group
+    int match_count;   // Number of B rows with the group's key
+};
 
 // --- Pre-Aggregation Method (Optimized) ---
 
+// The input files are streamed through kReadDepth buffers of kReadBufferSize bytes,
+// read ahead of the parser on background threads.
+const size_t kReadBufferSize = 1 << 20;
+const int kReadDepth = 4;
+
 /**
  * @brief Performs a join and aggregation using a pre-aggregation strategy.
  * This is more memory-efficient as it avoids materializing the full join result.
+ * A single hash table over A's groups holds {sum_v, match_count}; B only probes it.
+ * Disk reads overlap with parsing and aggregation.
  * @param file_a The filename for the left table (A).
  * @param file_b The filename for the right table (B).
  * @return A vector of AggregatedResult structs.
  */
 std::vector<AggregatedResult> pre_aggregation_join(const std::string& file_a, const std::string& file_b) {
-    std::ifstream file;
-    std::string line;
-
-    // 1. Read table A and pre-aggregate sums of 'v' for each key 'k'.
-    std::unordered_map<int, long long> pre_agg_a; // Use long long for sum to prevent overflow
-    file.open(file_a);
-    if (!file.is_open()) {
+    // 1. Build: read table A and pre-aggregate sums of 'v' for each key 'k'.
+    FlatHashMap<int, GroupJoinSlot> groups;
+    bool ok = for_each_line_chunk(file_a, kReadBufferSize, [&](const char* begin, const char* end) {
+        scan_table<SchemaA>(begin, end,
+            [&](const RowA& row) { groups[row.k].sum_v += row.v; },
+            [](Field) { /* ignore parse errors on this line */ });
+    }, nullptr, kReadDepth);
+    if (!ok) {
         std::cerr << "Error: Could not open file " << file_a << std::endl;
         return {};
     }
-    while (std::getline(file, line)) {
-        std::vector<std::string> tokens = parse_csv_line(line);
-        if (tokens.size() == 4) {
-            try {
-                int k = std::stoi(tokens[0]);
-                int v = std::stoi(tokens[1]);
-                pre_agg_a[k] += v;
-            } catch (const std::invalid_argument& ia) { /* ignore parse errors on this line */ }
-        }
-    }
-    file.close();
 
-    // 2. Read table B and count occurrences of each key 'k'.
-    std::unordered_map<int, int> key_counts_b;
-    file.open(file_b);
-     if (!file.is_open()) {
+    // 2. Probe: read table B and count the rows that match each existing group.
+    ok = for_each_line_chunk(file_b, kReadBufferSize, [&](const char* begin, const char* end) {
+        scan_table<SchemaB>(begin, end,
+            [&](const RowB& row) {
+                if (GroupJoinSlot* slot = groups.find(row.k)) {
+                    slot->match_count++;
+                }
+            },
+            [](Field) { /* ignore parse errors on this line */ });
+    }, nullptr, kReadDepth);
+    if (!ok) {
         std::cerr << "Error: Could not open file " << file_b << std::endl;
         return {};
     }
-    while (std::getline(file, line)) {
-        std::vector<std::string> tokens = parse_csv_line(line);
-        if (tokens.size() == 5) {
-            try {
-                int k = std::stoi(tokens[1]);
-                key_counts_b[k]++;
-            } catch (const std::invalid_argument& ia) { /* ignore parse errors on this line */ }
-        }
-    }
-    file.close();
 
-    // 3. Join the aggregated results.
+    // 3. Emit the pre-calculated sum from A multiplied by the count from B.
     std::vector<AggregatedResult> final_result;
-    for(const auto& b_pair : key_counts_b) {
-        int k = b_pair.first;
-        int count_in_b = b_pair.second;
-
-        // Find the matching key in the pre-aggregated map from table A
-        auto a_it = pre_agg_a.find(k);
-        if (a_it != pre_agg_a.end()) {
-            // If match found, multiply the pre-calculated sum from A by the count from B
-            long long sum_in_a = a_it->second;
-            long long final_sum = sum_in_a * count_in_b;
-            final_result.push_back({k, final_sum});
+    groups.for_each([&](int k, const GroupJoinSlot& slot) {
+        if (slot.match_count > 0) {
+            final_result.push_back({k, slot.sum_v * slot.match_count});
         }
-    }
+    });
 
+    TABLE_STATS(groups.stats().print("pre_aggregation_join");)
     return final_result;
 }
 
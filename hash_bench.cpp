@@ -0,0 +1,130 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+
+#include "flat_hash_map.h"
+#include "hash_policy.h"
+
+// Micro-benchmark of the hash policies in hash_policy.h. For uniform, sequential
+// and Zipf-distributed keys it aggregates the keys in a FlatHashMap per hash
+// function (as perform_aggregation does), then looks up existing keys, and
+// reports build and lookup throughput and the distribution of probe lengths.
+//
+// Usage: ./hash_bench [num_keys] [num_lookups]
+//   num_keys defaults to 2^20 and num_lookups to 2^22.
+
+/**
+ * @brief Draws count keys from a Zipf(s = 1) distribution over the ranks 1..domain.
+ */
+std::vector<int> zipf_keys(size_t count, size_t domain, std::mt19937& rng) {
+    std::vector<double> cdf(domain);
+    double sum = 0.0;
+    for (size_t rank = 1; rank <= domain; ++rank) {
+        sum += 1.0 / static_cast<double>(rank);
+        cdf[rank - 1] = sum;
+    }
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    std::vector<int> keys(count);
+    for (auto& key : keys) {
+        key = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()) + 1;
+    }
+    return keys;
+}
+
+/**
+ * @brief Aggregates keys into a FlatHashMap using Hash, probes it with lookups and prints one result line.
+ * @param distribution Name of the key distribution, for the output.
+ * @param keys The keys to insert (duplicates are aggregated).
+ * @param lookups Keys to look up; all of them are present in keys.
+ */
+template <typename Hash>
+void run_hash_benchmark(const std::string& distribution, const std::vector<int>& keys, const std::vector<int>& lookups) {
+    auto start = std::chrono::high_resolution_clock::now();
+    FlatHashMap<int, long long, std::numeric_limits<int>::min(), Hash> map;
+    for (int key : keys) {
+        map[key] += 1;
+    }
+    auto built = std::chrono::high_resolution_clock::now();
+    long long found = 0;
+    for (int key : lookups) {
+        const long long* count = map.find(key);
+        found += (count != nullptr) ? *count : 0;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> build_time = built - start;
+    std::chrono::duration<double> lookup_time = end - built;
+
+    // Probe lengths of every stored key, bucketed as 1, 2, 3-4, 5-8, 9-16, 17+.
+    size_t histogram[6] = {};
+    size_t total_length = 0;
+    size_t max_length = 0;
+    map.for_each([&](int key, long long) {
+        size_t length = map.probe_length(key);
+        total_length += length;
+        max_length = std::max(max_length, length);
+        size_t bucket = 0;
+        while (bucket < 5 && length > (size_t(1) << bucket)) {
+            ++bucket;
+        }
+        histogram[bucket]++;
+    });
+
+    std::cout << distribution << "," << Hash::name << "," << map.size() << ","
+              << keys.size() / build_time.count() / 1e6 << "," << lookups.size() / lookup_time.count() / 1e6 << ","
+              << static_cast<double>(total_length) / map.size() << "," << max_length;
+    for (size_t bucket : histogram) {
+        std::cout << "," << 100.0 * bucket / map.size();
+    }
+    std::cout << std::endl;
+    if (found == 0) {
+        std::cerr << "Lookups found no keys" << std::endl;
+    }
+}
+
+/**
+ * @brief Runs every hash policy on one key distribution.
+ */
+void run_distribution(const std::string& distribution, const std::vector<int>& keys, size_t num_lookups, std::mt19937& rng) {
+    std::vector<int> lookups(num_lookups);
+    for (auto& key : lookups) {
+        key = keys[rng() % keys.size()];
+    }
+    run_hash_benchmark<MultiplyShiftHash>(distribution, keys, lookups);
+    run_hash_benchmark<Murmur3Hash>(distribution, keys, lookups);
+    run_hash_benchmark<Crc32cHash>(distribution, keys, lookups);
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_keys = size_t(1) << 20;
+    size_t num_lookups = size_t(1) << 22;
+    if (argc > 1) {
+        num_keys = static_cast<size_t>(std::max(1, std::atoi(argv[1])));
+    }
+    if (argc > 2) {
+        num_lookups = static_cast<size_t>(std::max(1, std::atoi(argv[2])));
+    }
+
+    std::mt19937 rng(42);
+    std::cout << "distribution,hash,distinct_keys,build_mops,lookup_mops,mean_probe,max_probe,"
+              << "probe_1_pct,probe_2_pct,probe_3_4_pct,probe_5_8_pct,probe_9_16_pct,probe_17_plus_pct" << std::endl;
+
+    std::vector<int> keys(num_keys);
+    for (auto& key : keys) {
+        key = static_cast<int>(rng());
+    }
+    run_distribution("uniform", keys, num_lookups, rng);
+
+    for (size_t i = 0; i < num_keys; ++i) {
+        keys[i] = static_cast<int>(i);
+    }
+    run_distribution("sequential", keys, num_lookups, rng);
+
+    keys = zipf_keys(num_keys, num_keys, rng);
+    run_distribution("zipf", keys, num_lookups, rng);
+    return 0;
+}
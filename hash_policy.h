@@ -0,0 +1,67 @@
+#ifndef HASH_POLICY_H
+#define HASH_POLICY_H
+
+#include <cstdint>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+// -- Hash function policies for the hash tables --
+//
+// Every table takes its hash function as a template parameter: a type with a
+// static uint64_t hash(uint64_t key). The tables pick buckets from the HIGH
+// bits of the result (multiply-shift style), so a policy must mix its entropy
+// into the top bits; the low bits may be weaker.
+
+/**
+ * @brief Fibonacci multiply-shift: one multiplication, the default of every table.
+ */
+struct MultiplyShiftHash {
+    static constexpr const char* name = "multiply-shift";
+
+    static uint64_t hash(uint64_t key) {
+        return key * 0x9E3779B97F4A7C15ULL;
+    }
+};
+
+/**
+ * @brief MurmurHash3's 64-bit finalizer (fmix64): every input bit affects every output bit.
+ */
+struct Murmur3Hash {
+    static constexpr const char* name = "murmur3-fmix64";
+
+    static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDULL;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+};
+
+/**
+ * @brief CRC32C of the key, with the SSE4.2 crc32 instruction when available
+ * (bitwise software CRC otherwise). The 32-bit CRC fills both halves of the result.
+ */
+struct Crc32cHash {
+    static constexpr const char* name = "crc32c";
+
+    static uint64_t hash(uint64_t key) {
+#if defined(__SSE4_2__)
+        uint32_t crc = static_cast<uint32_t>(_mm_crc32_u64(0xFFFFFFFFu, key));
+#else
+        uint32_t crc = 0xFFFFFFFFu;
+        for (int byte = 0; byte < 8; ++byte) {
+            crc ^= static_cast<uint32_t>(key >> (8 * byte)) & 0xFF;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+            }
+        }
+#endif
+        return (static_cast<uint64_t>(crc) << 32) | crc;
+    }
+};
+
+#endif // HASH_POLICY_H
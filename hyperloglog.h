@@ -0,0 +1,64 @@
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "hash_policy.h"
+
+// -- Distinct-key estimation while loading --
+//
+// A HyperLogLog sketch keeps, for each of 2^14 registers, the longest run of
+// leading zero bits seen among the hashes routed to it. Updating it costs one
+// hash and one byte max per row, two sketches merge with a register-wise max
+// (so every parse chunk can keep its own), and the estimate is within about
+// 1% of the true number of distinct keys. The loaders fill one per table and
+// the join functions reserve their hash tables from the estimate up front
+// instead of rehashing as they grow.
+
+class HyperLogLog {
+public:
+    static constexpr int kPrecision = 14;
+    static constexpr size_t kRegisters = size_t(1) << kPrecision;
+
+    void add(int key) {
+        uint64_t h = Murmur3Hash::hash(static_cast<uint64_t>(static_cast<uint32_t>(key)));
+        size_t index = static_cast<size_t>(h >> (64 - kPrecision));
+        // The sentinel bit caps the run at 64 - kPrecision zeros.
+        uint64_t rest = (h << kPrecision) | (uint64_t(1) << (kPrecision - 1));
+        uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        registers_[index] = std::max(registers_[index], rank);
+    }
+
+    void merge(const HyperLogLog& other) {
+        for (size_t i = 0; i < kRegisters; ++i) {
+            registers_[i] = std::max(registers_[i], other.registers_[i]);
+        }
+    }
+
+    /**
+     * @brief Estimated number of distinct keys added (standard error about 0.8%).
+     */
+    size_t estimate() const {
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (size_t i = 0; i < kRegisters; ++i) {
+            sum += std::ldexp(1.0, -registers_[i]);
+            zeros += registers_[i] == 0 ? 1 : 0;
+        }
+        const double m = static_cast<double>(kRegisters);
+        double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+        // Small cardinalities: linear counting over the empty registers is more accurate.
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / static_cast<double>(zeros));
+        }
+        return static_cast<size_t>(estimate + 0.5);
+    }
+
+private:
+    uint8_t registers_[kRegisters] = {};
+};
+
+#endif // HYPERLOGLOG_H
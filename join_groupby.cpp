@@ -1,11 +1,18 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <variant>
+#include <chrono>
 #include <algorithm>
+
+#include "csr_hash_table.h"
+#include "csv_scan.h"
+#include "eager_aggregation.h"
+#include "fast_io.h"
+#include "flat_hash_map.h"
+#include "table_schema.h"
+
 // -- Data Structures to represent table rows --
 
 // Represents a single row from table A
@@ -17,116 +24,86 @@ struct RowA {
 // Represents a single row from table B
 struct RowB {
     int k;
+    int w;  // Numeric attribute aggregated by the B-side queries
+    int g;  // Grouping attribute of the B-side queries
 };
 
 // Represents a row after the join operation
-// Materializing A.k, A.v, B.k
+// Materializing A.k, A.v, B.k, B.w, B.g
 struct JoinedRow {
     int a_k;
     int a_v;
     int b_k;
+    int b_w;
+    int b_g;
 };
 
-// Represents a final aggregated result row
+// Represents a final aggregated result row (k is the group, whichever column it comes from)
 struct AggregatedResult {
     int k;
-    int sum_v;
+    long long sum_v;
 };
 
-// -- Helper Functions --
-
-/**
- * @brief Parses a CSV string and returns a vector of strings.
- * @param line The string line to parse.
- * @param delimiter The character to split the string by.
- * @return A vector of string tokens.
- */
-std::vector<std::string> parse_csv_line(const std::string& line, char delimiter = ',') {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(line);
-    while (std::getline(tokenStream, token, delimiter)) {
-        // Trim leading/trailing whitespace
-        size_t first = token.find_first_not_of(" \t\n\r");
-        if (std::string::npos == first) {
-            tokens.push_back("");
-            continue;
-        }
-        size_t last = token.find_last_not_of(" \t\n\r");
-        tokens.push_back(token.substr(first, (last - first + 1)));
-    }
-    return tokens;
-}
-
-
 // -- Core Logic Functions --
 
+// Columns of the wide input rows that the query actually reads; rows of another width are skipped
+using SchemaA = ProjectedSchema<RowA, 4, ',', Column<0, &RowA::k>, Column<1, &RowA::v>>; // of k, v, 'A', 1.5
+using SchemaB = ProjectedSchema<RowB, 5, ',', Column<0, &RowB::k>>; // of 5 columns
+// B's attributes as well, for the queries that group or aggregate on B's columns only
+using SchemaBAttributes = ProjectedSchema<RowB, 5, ',', Column<0, &RowB::k>, Column<1, &RowB::w>, Column<2, &RowB::g>>;
+
 /**
  * @brief Reads data from a CSV file into a vector of RowA structs.
+ * Only the projected columns (SchemaA) are parsed; the rest of each row is skipped, and
+ * rows that are not 4 fields wide are skipped silently.
  * @param filename The name of the file to read.
  * @return A vector of RowA structs.
  */
 std::vector<RowA> read_table_a(const std::string& filename) {
     std::vector<RowA> table;
-    std::ifstream file(filename);
-    std::string line;
+    MappedFile file(filename);
 
     if (!file.is_open()) {
         std::cerr << "Error: Could not open file " << filename << std::endl;
         return table;
     }
 
-    // Skip header if it exists
-    // std::getline(file, line);
-
-    while (std::getline(file, line)) {
-        std::vector<std::string> tokens = parse_csv_line(line);
-        if (tokens.size() == 4) {
-            try {
-                RowA row;
-                row.k = std::stoi(tokens[0]);
-                row.v = std::stoi(tokens[1]);
-                table.push_back(row);
-            } catch (const std::invalid_argument& ia) {
-                std::cerr << "Invalid argument in file " << filename << ": " << ia.what() << " on line: " << line << '\n';
-            }
-        }
-    }
-    file.close();
+    scan_table<SchemaA>(file.data(), file.end(),
+        [&](const RowA& row) { table.push_back(row); },
+        [&](Field line) {
+            std::cerr << "Invalid argument in file " << filename << " on line: " << std::string(line.begin, line.end) << '\n';
+        });
     return table;
 }
 
 /**
  * @brief Reads data from a CSV file into a vector of RowB structs.
+ * Only the projected columns (SchemaB, or SchemaBAttributes) are parsed; the rest of each row
+ * is skipped, and rows that are not 5 fields wide are skipped silently.
  * @param filename The name of the file to read.
+ * @param invalid_rows Optional; if given, rows whose columns fail to parse are counted here
+ *        instead of being reported one by one.
  * @return A vector of RowB structs.
  */
-std::vector<RowB> read_table_b(const std::string& filename) {
+template <typename Schema = SchemaB>
+std::vector<RowB> read_table_b(const std::string& filename, size_t* invalid_rows = nullptr) {
     std::vector<RowB> table;
-    std::ifstream file(filename);
-    std::string line;
+    MappedFile file(filename);
 
     if (!file.is_open()) {
         std::cerr << "Error: Could not open file " << filename << std::endl;
         return table;
     }
 
-    // Skip header if it exists
-    // std::getline(file, line);
-
-    while (std::getline(file, line)) {
-        std::vector<std::string> tokens = parse_csv_line(line);
-        if (tokens.size() == 5) {
-             try {
-                RowB row;
-                row.k = std::stoi(tokens[0]);
-                table.push_back(row);
-            } catch (const std::invalid_argument& ia) {
-                std::cerr << "Invalid argument in file " << filename << ": " << ia.what() << " on line: " << line << '\n';
+    scan_table<Schema>(file.data(), file.end(),
+        [&](const RowB& row) { table.push_back(row); },
+        [&](Field line) {
+            if (invalid_rows != nullptr) {
+                ++*invalid_rows;
+                return;
             }
-        }
-    }
-    file.close();
+            std::cerr << "Invalid argument in file " << filename << " on line: " << std::string(line.begin, line.end) << '\n';
+        });
     return table;
 }
 
@@ -137,52 +114,89 @@ std::vector<RowB> read_table_b(const std::string& filename) {
  * @return A vector of JoinedRow structs representing the result of the join.
  */
 std::vector<JoinedRow> hash_join(const std::vector<RowA>& table_a, const std::vector<RowB>& table_b) {
-    // 1. Build Phase: Create a hash table on the key 'k' from the left table (A)
-    std::unordered_map<int, std::vector<RowA>> hash_table;
-    for (const auto& row_a : table_a) {
-        hash_table[row_a.k].push_back(row_a);
-    }
-    
+    // 1. Build Phase: Create a hash table on the key 'k' from the left table (A).
+    // Rows are counted per bucket, then scattered into one contiguous array.
+    CsrHashTable<RowA> hash_table;
+    hash_table.build(table_a.data(), table_a.size(),
+        [](const RowA& row) { return row.k; },
+        [](const RowA& row) { return row; });
+
     std::vector<JoinedRow> joined_result;
 
     // 2. Probe Phase: Iterate through the right table (B) and probe the hash table
     for (const auto& row_b : table_b) {
-        // Check if the key from table B exists in our hash table
-        auto it = hash_table.find(row_b.k);
-        if (it != hash_table.end()) {
-            // If a match is found, materialize the joined rows
-            for (const auto& matching_row_a : it->second) {
-                joined_result.push_back({matching_row_a.k, matching_row_a.v, row_b.k});
-            }
-        }
+        // If a match is found, materialize the joined rows
+        hash_table.for_each_match(row_b.k, [&](const RowA& matching_row_a) {
+            joined_result.push_back({matching_row_a.k, matching_row_a.v, row_b.k, row_b.w, row_b.g});
+        });
     }
 
+    TABLE_STATS(hash_table.stats().print("hash_join");)
     return joined_result;
 }
 
 /**
- * @brief Performs aggregation (GROUP BY k, SUM v) on the joined data.
+ * @brief Performs aggregation (GROUP BY group_of, SUM value_of) on the joined data.
  * @param joined_data The vector of JoinedRow structs.
+ * @param group_of Callable (const JoinedRow&) -> int, the grouping column (e.g. a_k).
+ * @param value_of Callable (const JoinedRow&) -> long long, the summed column (e.g. a_v).
  * @return A vector of AggregatedResult structs.
  */
-std::vector<AggregatedResult> perform_aggregation(const std::vector<JoinedRow>& joined_data) {
-    // Use a map to store the sum for each key 'k'
-    std::unordered_map<int, int> aggregation_map;
+template <typename GroupFn, typename ValueFn>
+std::vector<AggregatedResult> perform_aggregation(const std::vector<JoinedRow>& joined_data, GroupFn group_of, ValueFn value_of) {
+    // Use a map to store the sum for each group
+    FlatHashMap<int, long long> aggregation_map;
 
     for (const auto& row : joined_data) {
-        aggregation_map[row.a_k] += row.a_v;
+        aggregation_map[group_of(row)] += value_of(row);
     }
 
     // Convert the map to the final result vector
     std::vector<AggregatedResult> final_result;
-    for (const auto& pair : aggregation_map) {
-        final_result.push_back({pair.first, pair.second});
-    }
+    final_result.reserve(aggregation_map.size());
+    aggregation_map.for_each([&](int k, long long sum_v) {
+        final_result.push_back({k, sum_v});
+    });
 
+    TABLE_STATS(aggregation_map.stats().print("perform_aggregation");)
     return final_result;
 }
 
 
+/**
+ * @brief Runs eager_aggregate_join and collects its groups as AggregatedResult rows.
+ * @see eager_aggregate_join for the parameters.
+ */
+template <typename RowG, typename RowO, typename KeyOfG, typename KeyOfO, typename GroupFn, typename ValueOfG, typename ValueOfO>
+std::vector<AggregatedResult> eager_aggregation(const std::vector<RowG>& grouped, const std::vector<RowO>& other, KeyOfG key_of_grouped,
+                                                KeyOfO key_of_other, GroupFn group_of, ValueOfG value_of_grouped, ValueOfO value_of_other) {
+    std::vector<AggregatedResult> final_result;
+    eager_aggregate_join(grouped, other, key_of_grouped, key_of_other, group_of, value_of_grouped, value_of_other,
+        [&](int group, long long sum_v) { final_result.push_back({group, sum_v}); });
+    return final_result;
+}
+
+/**
+ * @brief Returns true if both result sets hold the same groups with the same sums, in any order.
+ */
+bool same_results(std::vector<AggregatedResult> a, std::vector<AggregatedResult> b) {
+    auto by_k = [](const AggregatedResult& x, const AggregatedResult& y) { return x.k < y.k; };
+    std::sort(a.begin(), a.end(), by_k);
+    std::sort(b.begin(), b.end(), by_k);
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const AggregatedResult& x, const AggregatedResult& y) { return x.k == y.k && x.sum_v == y.sum_v; });
+}
+
+/**
+ * @brief Prints one query's group count and its time with the materialized join vs. eager aggregation.
+ * @param join_ms Time of the shared hash_join, added to the materialized plan's aggregation time.
+ */
+void report_eager_aggregation(const std::string& query, const std::vector<AggregatedResult>& materialized, double join_ms,
+                              double aggregation_ms, const std::vector<AggregatedResult>& eager, double eager_ms) {
+    std::cout << "Query " << query << ": " << eager.size() << " groups, join-then-aggregate " << join_ms + aggregation_ms
+              << " ms, eager aggregation " << eager_ms << " ms" << (same_results(materialized, eager) ? "" : " (RESULTS DIFFER)") << std::endl;
+}
+
 /**
  * @brief Displays the final aggregated results to the console.
  * @param results The vector of AggregatedResult structs to display.
@@ -191,7 +205,7 @@ void display_results(const std::string& title, const std::vector<AggregatedResul
     std::cout << "\n--- " << title << " ---" << std::endl;
     std::cout << "k\t|\tsumm" << std::endl;
     std::cout << "--------------------------------" << std::endl;
-    // Note: Iterating over an unordered_map gives no guarantee of order.
+    // Note: Iterating over a hash map gives no guarantee of order.
     // For consistent output for comparison, we can sort the results.
     // This is optional and adds a small overhead.
     std::vector<AggregatedResult> sorted_results = results;
@@ -242,13 +256,88 @@ int main() {
     }
 
     // 2. Perform the hash join
+    auto join_start = std::chrono::high_resolution_clock::now();
     std::vector<JoinedRow> joined_table = hash_join(table_a, table_b);
+    std::chrono::duration<double, std::milli> join_ms = std::chrono::high_resolution_clock::now() - join_start;
 
     // 3. Perform the aggregation
-    std::vector<AggregatedResult> final_results = perform_aggregation(joined_table);
+    auto aggregation_start = std::chrono::high_resolution_clock::now();
+    std::vector<AggregatedResult> final_results = perform_aggregation(joined_table,
+        [](const JoinedRow& row) { return row.a_k; }, [](const JoinedRow& row) { return row.a_v; });
+    std::chrono::duration<double, std::milli> aggregation_ms = std::chrono::high_resolution_clock::now() - aggregation_start;
     
     // 4. Display the final results
     display_results("Final Results (Join-Aggregation)",final_results);
 
+    // 5. The same query and some that group or aggregate on B's columns, each both over the
+    //    materialized join and with the aggregation pushed below the join.
+    auto key_of_a = [](const RowA& row) { return row.k; };
+    auto key_of_b = [](const RowB& row) { return row.k; };
+    auto none_a = [](const RowA&) { return 0LL; };
+    auto none_b = [](const RowB&) { return 0LL; };
+    std::cout << std::endl;
+
+    // SUM(A.v) GROUP BY A.k: A is grouped, B contributes its match count.
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<AggregatedResult> eager_results = eager_aggregation(table_a, table_b, key_of_a, key_of_b,
+        [](const RowA& row) { return row.k; }, [](const RowA& row) { return static_cast<long long>(row.v); }, none_b);
+    std::chrono::duration<double, std::milli> eager_ms = std::chrono::high_resolution_clock::now() - start;
+    report_eager_aggregation("SUM(A.v) GROUP BY A.k", final_results, join_ms.count(), aggregation_ms.count(), eager_results, eager_ms.count());
+
+    // The B-side queries read B.w and B.g too; rows where those are not integers only drop out
+    // of these queries, not out of the Join-Aggregation above.
+    size_t skipped_b = 0;
+    table_b = read_table_b<SchemaBAttributes>("B.txt", &skipped_b);
+    if (skipped_b > 0) {
+        std::cout << "B-side queries: " << skipped_b << " rows of B skipped (w or g not an integer)" << std::endl;
+    }
+    join_start = std::chrono::high_resolution_clock::now();
+    joined_table = hash_join(table_a, table_b);
+    join_ms = std::chrono::high_resolution_clock::now() - join_start;
+
+    // SUM(A.v) GROUP BY B.g: B is grouped, A contributes SUM(v) per key.
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<AggregatedResult> materialized_results = perform_aggregation(joined_table,
+        [](const JoinedRow& row) { return row.b_g; }, [](const JoinedRow& row) { return row.a_v; });
+    aggregation_ms = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    eager_results = eager_aggregation(table_b, table_a, key_of_b, key_of_a,
+        [](const RowB& row) { return row.g; }, none_b, [](const RowA& row) { return static_cast<long long>(row.v); });
+    eager_ms = std::chrono::high_resolution_clock::now() - start;
+    report_eager_aggregation("SUM(A.v) GROUP BY B.g", materialized_results, join_ms.count(), aggregation_ms.count(), eager_results, eager_ms.count());
+
+    // SUM(B.w) GROUP BY A.k: A is grouped, B contributes SUM(w) per key.
+    start = std::chrono::high_resolution_clock::now();
+    materialized_results = perform_aggregation(joined_table,
+        [](const JoinedRow& row) { return row.a_k; }, [](const JoinedRow& row) { return row.b_w; });
+    aggregation_ms = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    eager_results = eager_aggregation(table_a, table_b, key_of_a, key_of_b,
+        [](const RowA& row) { return row.k; }, none_a, [](const RowB& row) { return static_cast<long long>(row.w); });
+    eager_ms = std::chrono::high_resolution_clock::now() - start;
+    report_eager_aggregation("SUM(B.w) GROUP BY A.k", materialized_results, join_ms.count(), aggregation_ms.count(), eager_results, eager_ms.count());
+
+    // SUM(A.v + B.w), COUNT(*) GROUP BY B.g: both sides aggregated; the count is SUM(1) on B.
+    start = std::chrono::high_resolution_clock::now();
+    materialized_results = perform_aggregation(joined_table,
+        [](const JoinedRow& row) { return row.b_g; }, [](const JoinedRow& row) { return static_cast<long long>(row.a_v) + row.b_w; });
+    aggregation_ms = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    eager_results = eager_aggregation(table_b, table_a, key_of_b, key_of_a,
+        [](const RowB& row) { return row.g; }, [](const RowB& row) { return static_cast<long long>(row.w); },
+        [](const RowA& row) { return static_cast<long long>(row.v); });
+    eager_ms = std::chrono::high_resolution_clock::now() - start;
+    report_eager_aggregation("SUM(A.v + B.w) GROUP BY B.g", materialized_results, join_ms.count(), aggregation_ms.count(), eager_results, eager_ms.count());
+
+    start = std::chrono::high_resolution_clock::now();
+    materialized_results = perform_aggregation(joined_table,
+        [](const JoinedRow& row) { return row.b_g; }, [](const JoinedRow&) { return 1LL; });
+    aggregation_ms = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    eager_results = eager_aggregation(table_b, table_a, key_of_b, key_of_a,
+        [](const RowB& row) { return row.g; }, [](const RowB&) { return 1LL; }, none_a);
+    eager_ms = std::chrono::high_resolution_clock::now() - start;
+    report_eager_aggregation("COUNT(*) GROUP BY B.g", materialized_results, join_ms.count(), aggregation_ms.count(), eager_results, eager_ms.count());
+
     return 0;
 }
@@ -0,0 +1,139 @@
+#ifndef RADIX_PARTITION_H
+#define RADIX_PARTITION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "hash_policy.h"
+
+// -- Radix partitioning for cache-sized hash joins --
+//
+// Once the build side is much larger than the last-level cache, every probe of
+// a single global hash table is a cache and TLB miss. Radix partitioning first
+// splits both inputs by the same bits of the key's hash, so that each pair of
+// partitions can be joined with a small hash table that stays in cache.
+//
+// Each pass counts the rows per partition, then scatters them. Rows are staged
+// in one cache-line buffer per partition (software write-combining) and copied
+// out a line's worth of rows at a time. The partitions are packed, not padded,
+// so a flush usually straddles two lines of the output rather than filling one
+// exactly; it still batches the scattered stores. A pass writes to at most
+// 2^kMaxRadixBitsPerPass partitions, so its output cursors stay within the TLB's
+// reach. More radix bits than that are split over two passes, the second
+// refining each partition of the first. The partition bits come from the
+// Murmur3 finalizer, which is independent of the multiply-shift hash the join
+// tables use for their buckets.
+
+constexpr int kMaxRadixBitsPerPass = 8;
+constexpr int kMaxRadixBits = 2 * kMaxRadixBitsPerPass;
+
+/**
+ * @brief The rows of a table grouped by partition.
+ */
+template <typename Row>
+struct RadixPartitions {
+    std::unique_ptr<Row[]> rows;
+    std::vector<size_t> offsets;  // Partition p is rows[offsets[p], offsets[p + 1])
+
+    size_t num_partitions() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    const Row* begin(size_t p) const { return rows.get() + offsets[p]; }
+    size_t size(size_t p) const { return offsets[p + 1] - offsets[p]; }
+};
+
+/**
+ * @brief Number of partitioning passes used for radix_bits bits.
+ */
+inline int radix_passes(int radix_bits) {
+    return radix_bits <= kMaxRadixBitsPerPass ? 1 : 2;
+}
+
+/**
+ * @brief The hash whose high bits select a key's partition.
+ */
+inline uint64_t radix_hash(int key) {
+    return Murmur3Hash::hash(static_cast<uint64_t>(static_cast<uint32_t>(key)));
+}
+
+/**
+ * @brief Scatters rows[0..count) into out by (radix_hash(key) >> shift) & (2^bits - 1).
+ * @param out Receives the rows, grouped by partition; must hold count rows.
+ * @param offsets Receives 2^bits + 1 partition offsets relative to out.
+ */
+template <typename Row, typename KeyFn>
+void radix_partition_pass(const Row* rows, size_t count, int bits, int shift, KeyFn key_of, Row* out, size_t* offsets) {
+    const size_t fanout = size_t(1) << bits;
+    const uint64_t mask = fanout - 1;
+    auto partition_of = [&](const Row& row) { return static_cast<size_t>((radix_hash(key_of(row)) >> shift) & mask); };
+
+    // Pass 1: histogram, turned into partition start offsets.
+    std::fill(offsets, offsets + fanout + 1, size_t(0));
+    for (size_t i = 0; i < count; ++i) {
+        offsets[partition_of(rows[i]) + 1]++;
+    }
+    for (size_t p = 0; p < fanout; ++p) {
+        offsets[p + 1] += offsets[p];
+    }
+
+    // Pass 2: stage each row in its partition's cache-line buffer; flush it once full.
+    constexpr size_t kLineRows = sizeof(Row) < 64 ? 64 / sizeof(Row) : 1;
+    struct alignas(64) Line {
+        Row rows[kLineRows];
+    };
+    std::unique_ptr<Line[]> lines(new Line[fanout]);
+    std::vector<size_t> cursors(offsets, offsets + fanout);
+    std::vector<uint8_t> fill(fanout, 0);
+    for (size_t i = 0; i < count; ++i) {
+        size_t p = partition_of(rows[i]);
+        lines[p].rows[fill[p]] = rows[i];
+        if (++fill[p] == kLineRows) {
+            std::memcpy(out + cursors[p], lines[p].rows, sizeof(Line::rows));
+            cursors[p] += kLineRows;
+            fill[p] = 0;
+        }
+    }
+    for (size_t p = 0; p < fanout; ++p) {
+        std::memcpy(out + cursors[p], lines[p].rows, fill[p] * sizeof(Row));
+    }
+}
+
+/**
+ * @brief Splits rows[0..count) into 2^radix_bits partitions by the high bits of radix_hash(key).
+ * @param radix_bits Partition bits, 1 to kMaxRadixBits; above kMaxRadixBitsPerPass they
+ *        are split over two passes.
+ * @param key_of Callable (const Row&) -> int.
+ */
+template <typename Row, typename KeyFn>
+RadixPartitions<Row> radix_partition(const Row* rows, size_t count, int radix_bits, KeyFn key_of) {
+    RadixPartitions<Row> result;
+    result.rows.reset(new Row[count]);
+    result.offsets.resize((size_t(1) << radix_bits) + 1);
+    if (radix_passes(radix_bits) == 1) {
+        radix_partition_pass(rows, count, radix_bits, 64 - radix_bits, key_of, result.rows.get(), result.offsets.data());
+        return result;
+    }
+
+    // Two passes: split by the top bits into a scratch array, then refine each of those partitions.
+    int bits1 = (radix_bits + 1) / 2;
+    int bits2 = radix_bits - bits1;
+    std::unique_ptr<Row[]> scratch(new Row[count]);
+    std::vector<size_t> offsets1((size_t(1) << bits1) + 1);
+    radix_partition_pass(rows, count, bits1, 64 - bits1, key_of, scratch.get(), offsets1.data());
+    const size_t fanout2 = size_t(1) << bits2;
+    std::vector<size_t> offsets2(fanout2 + 1);
+    for (size_t p1 = 0; p1 + 1 < offsets1.size(); ++p1) {
+        size_t base = offsets1[p1];
+        radix_partition_pass(scratch.get() + base, offsets1[p1 + 1] - base, bits2, 64 - radix_bits, key_of,
+                             result.rows.get() + base, offsets2.data());
+        for (size_t p2 = 0; p2 < fanout2; ++p2) {
+            result.offsets[(p1 << bits2) + p2] = base + offsets2[p2];
+        }
+    }
+    result.offsets.back() = count;
+    return result;
+}
+
+#endif // RADIX_PARTITION_H
@@ -0,0 +1,62 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// -- LSD radix sort of rows by an int key --
+//
+// Sorts by the key's four bytes, least significant first, each pass a stable
+// counting scatter into a scratch array. One read of the input builds all four
+// histograms, and a pass whose byte is the same for every row (e.g. the high
+// bytes of keys below 2^24) is skipped. The sign bit is flipped so that negative
+// keys sort before positive ones.
+
+/**
+ * @brief Sorts rows[0..count) by key_of(row) in ascending order; stable.
+ * @param key_of Callable (const Row&) -> int.
+ */
+template <typename Row, typename KeyFn>
+void radix_sort(Row* rows, size_t count, KeyFn key_of) {
+    constexpr int kPasses = 4;
+    constexpr size_t kBuckets = 256;
+    auto digit_of = [&](const Row& row, int pass) {
+        uint32_t key = static_cast<uint32_t>(key_of(row)) ^ 0x80000000u;
+        return static_cast<size_t>((key >> (8 * pass)) & 0xFF);
+    };
+
+    size_t histograms[kPasses][kBuckets] = {};
+    for (size_t i = 0; i < count; ++i) {
+        for (int pass = 0; pass < kPasses; ++pass) {
+            histograms[pass][digit_of(rows[i], pass)]++;
+        }
+    }
+
+    std::unique_ptr<Row[]> scratch(new Row[count]);
+    Row* from = rows;
+    Row* to = scratch.get();
+    for (int pass = 0; pass < kPasses; ++pass) {
+        size_t* histogram = histograms[pass];
+        if (std::find(histogram, histogram + kBuckets, count) != histogram + kBuckets) {
+            continue;  // Every row has the same digit: the pass would not move anything.
+        }
+        size_t offset = 0;
+        for (size_t b = 0; b < kBuckets; ++b) {
+            size_t bucket_count = histogram[b];
+            histogram[b] = offset;
+            offset += bucket_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            to[histogram[digit_of(from[i], pass)]++] = from[i];
+        }
+        std::swap(from, to);
+    }
+    if (from != rows) {
+        std::memcpy(rows, from, count * sizeof(Row));
+    }
+}
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,335 @@
+#ifndef SWISS_HASH_MAP_H
+#define SWISS_HASH_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "hash_policy.h"
+#include "table_stats.h"
+
+// -- Hash map with SIMD-probed control bytes (Swiss-table layout) --
+//
+// Next to the key and payload arrays the map keeps one control byte per slot:
+// kCtrlEmpty for a free slot, otherwise a 7-bit tag taken from the key's hash.
+// Slots are grouped by 16; a probe compares the tag against a whole group of
+// control bytes with one SSE2 compare and only reads the keys whose tags match.
+// A group that still has a free slot ends the probe sequence, so most misses
+// are answered from the control bytes alone, without touching key storage.
+// Without SSE2 the group is matched with a scalar loop.
+
+constexpr size_t kSwissGroupWidth = 16;
+constexpr int8_t kCtrlEmpty = -128;
+
+/**
+ * @brief Bit i is set for every control byte i of the 16-byte group equal to value.
+ */
+inline uint32_t swiss_match_group(const int8_t* group, int8_t value) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kSwissGroupWidth; ++i) {
+        mask |= uint32_t(group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Hash map from an integer key to a default-constructible payload.
+ * Same interface as FlatHashMap, but every key value (no sentinel) can be stored.
+ * @tparam Key Integer key type.
+ * @tparam Value Payload type; new entries start value-initialized.
+ * @tparam Hash Hash policy (see hash_policy.h); the group and the tag come from its high bits.
+ */
+template <typename Key, typename Value, typename Hash = MultiplyShiftHash>
+class SwissHashMap {
+    static_assert(std::is_integral<Key>::value, "SwissHashMap keys are integers");
+
+public:
+    /**
+     * @brief Creates a map sized to hold expected_size keys without rehashing.
+     */
+    explicit SwissHashMap(size_t expected_size = 0) { rehash(capacity_for(expected_size)); }
+
+    SwissHashMap(const SwissHashMap&) = delete;
+    SwissHashMap& operator=(const SwissHashMap&) = delete;
+    SwissHashMap(SwissHashMap&&) = default;
+    SwissHashMap& operator=(SwissHashMap&&) = default;
+
+    /**
+     * @brief Returns the payload of key, inserting a value-initialized one if it is missing.
+     */
+    Value& operator[](Key key) {
+        uint64_t h = hash(key);
+        int8_t tag = tag_of(h);
+        for (size_t group = group_of(h);; group = (group + 1) & group_mask_) {
+            size_t base = group * kSwissGroupWidth;
+            for (uint32_t m = swiss_match_group(&ctrl_[base], tag); m != 0; m &= m - 1) {
+                size_t slot = base + __builtin_ctz(m);
+                if (keys_[slot] == key) {
+                    TABLE_STATS(record_probe(h, group, true);)
+                    return values_[slot];
+                }
+            }
+            uint32_t empty = swiss_match_group(&ctrl_[base], kCtrlEmpty);
+            if (empty != 0) {
+                if ((size_ + 1) * 8 > capacity_ * 7) {
+                    rehash(capacity_ * 2);
+                    return (*this)[key];
+                }
+                size_t slot = base + __builtin_ctz(empty);
+                ctrl_[slot] = tag;
+                keys_[slot] = key;
+                ++size_;
+                TABLE_STATS(record_probe(h, group, false);)
+                return values_[slot];
+            }
+        }
+    }
+
+    /**
+     * @brief Returns a pointer to the payload of key, or nullptr if the key is absent.
+     */
+    Value* find(Key key) {
+        uint64_t h = hash(key);
+        int8_t tag = tag_of(h);
+        for (size_t group = group_of(h);; group = (group + 1) & group_mask_) {
+            size_t base = group * kSwissGroupWidth;
+            for (uint32_t m = swiss_match_group(&ctrl_[base], tag); m != 0; m &= m - 1) {
+                size_t slot = base + __builtin_ctz(m);
+                if (keys_[slot] == key) {
+                    TABLE_STATS(record_probe(h, group, true);)
+                    return &values_[slot];
+                }
+            }
+            if (swiss_match_group(&ctrl_[base], kCtrlEmpty) != 0) {
+                TABLE_STATS(record_probe(h, group, false);)
+                return nullptr;
+            }
+        }
+    }
+
+    const Value* find(Key key) const {
+        return const_cast<SwissHashMap*>(this)->find(key);
+    }
+
+    /**
+     * @brief Starts loading the first control group of key into cache ahead of a find or insert.
+     */
+    void prefetch(Key key) const {
+        __builtin_prefetch(&ctrl_[group_of(hash(key)) * kSwissGroupWidth]);
+    }
+
+    /**
+     * @brief Calls fn(Key key, Value& value) for every entry, in unspecified order.
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) {
+        for (size_t slot = 0; slot < capacity_; ++slot) {
+            if (ctrl_[slot] != kCtrlEmpty) {
+                fn(keys_[slot], values_[slot]);
+            }
+        }
+    }
+
+    /**
+     * @brief Grows the table so that expected_size keys fit without rehashing.
+     */
+    void reserve(size_t expected_size) {
+        size_t capacity = capacity_for(expected_size);
+        if (capacity > capacity_) {
+            rehash(capacity);
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+#ifdef HASH_TABLE_STATS
+    /**
+     * @brief Lookup and allocation counters; probe lengths count control groups.
+     */
+    TableStats stats() const {
+        TableStats stats = stats_;
+        stats.size = size_;
+        stats.capacity = capacity_;
+        return stats;
+    }
+
+    void clear_probe_stats() { stats_.clear_probes(); }
+#endif
+
+private:
+#ifdef HASH_TABLE_STATS
+    // Records a lookup with hash h that ended in group.
+    void record_probe(uint64_t h, size_t group, bool hit) const {
+        stats_.record_probe(((group - group_of(h)) & group_mask_) + 1, hit);
+    }
+#endif
+
+    // Smallest power-of-two slot count (at least one group) under the 7/8 load limit.
+    static size_t capacity_for(size_t expected_size) {
+        size_t capacity = kSwissGroupWidth;
+        while (capacity * 7 < expected_size * 8) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    static uint64_t hash(Key key) {
+        return Hash::hash(static_cast<uint64_t>(key));
+    }
+
+    // The top bits of the hash pick the group, the 7 bits below them form the tag.
+    size_t group_of(uint64_t h) const {
+        return group_shift_ == 64 ? 0 : static_cast<size_t>(h >> group_shift_);
+    }
+    int8_t tag_of(uint64_t h) const {
+        return static_cast<int8_t>((h >> (group_shift_ - 7)) & 0x7F);
+    }
+
+    void rehash(size_t new_capacity) {
+        std::unique_ptr<int8_t[]> old_ctrl = std::move(ctrl_);
+        std::unique_ptr<Key[]> old_keys = std::move(keys_);
+        std::unique_ptr<Value[]> old_values = std::move(values_);
+        size_t old_capacity = capacity_;
+        TABLE_STATS(stats_.resizes += size_ != 0 ? 1 : 0;)
+        TABLE_STATS(stats_.bytes_allocated = new_capacity * (1 + sizeof(Key) + sizeof(Value));)
+
+        capacity_ = new_capacity;
+        size_t num_groups = new_capacity / kSwissGroupWidth;
+        group_mask_ = num_groups - 1;
+        group_shift_ = 64 - __builtin_ctzll(num_groups);
+        ctrl_.reset(new int8_t[new_capacity]);
+        std::memset(ctrl_.get(), kCtrlEmpty, new_capacity);
+        keys_.reset(new Key[new_capacity]);
+        values_.reset(new Value[new_capacity]());
+        for (size_t slot = 0; slot < old_capacity; ++slot) {
+            if (old_ctrl[slot] != kCtrlEmpty) {
+                uint64_t h = hash(old_keys[slot]);
+                for (size_t group = group_of(h);; group = (group + 1) & group_mask_) {
+                    size_t base = group * kSwissGroupWidth;
+                    uint32_t empty = swiss_match_group(&ctrl_[base], kCtrlEmpty);
+                    if (empty != 0) {
+                        size_t target = base + __builtin_ctz(empty);
+                        ctrl_[target] = tag_of(h);
+                        keys_[target] = old_keys[slot];
+                        values_[target] = old_values[slot];
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<int8_t[]> ctrl_;
+    std::unique_ptr<Key[]> keys_;
+    std::unique_ptr<Value[]> values_;
+    size_t capacity_ = 0;
+    size_t group_mask_ = 0;
+    unsigned group_shift_ = 64;
+    size_t size_ = 0;
+    TABLE_STATS(mutable TableStats stats_;)
+};
+
+/**
+ * @brief Multi-valued join table with the same build/for_each_match interface as CsrHashTable.
+ * A SwissHashMap directory maps each distinct key to its range in one contiguous payload
+ * array, so a probe that misses never leaves the directory's control bytes.
+ * @tparam Payload The value stored with each key.
+ * @tparam Hash Hash policy of the directory.
+ */
+template <typename Payload, typename Hash = MultiplyShiftHash>
+class SwissJoinTable {
+public:
+    /**
+     * @brief Builds the table from rows[0..count).
+     * @param rows Random-access input rows.
+     * @param count Number of rows; must be below 2^32.
+     * @param key_of Callable (const Row&) -> int.
+     * @param payload_of Callable (const Row&) -> Payload.
+     */
+    template <typename Row, typename KeyFn, typename PayloadFn>
+    void build(const Row* rows, size_t count, KeyFn key_of, PayloadFn payload_of) {
+        // Pass 1: count rows per key, then assign each key its range of the payload array.
+        for (size_t i = 0; i < count; ++i) {
+            directory_[key_of(rows[i])].count++;
+        }
+        uint32_t begin = 0;
+        directory_.for_each([&](int, KeyRange& range) {
+            range.begin = begin;
+            begin += range.count;
+            range.count = 0;
+        });
+
+        // Pass 2: scatter the payloads; count climbs back to its final value as the cursor.
+        payloads_.reset(new Payload[count]);
+        for (size_t i = 0; i < count; ++i) {
+            KeyRange* range = directory_.find(key_of(rows[i]));
+            payloads_[range->begin + range->count++] = payload_of(rows[i]);
+        }
+        size_ = count;
+        TABLE_STATS(directory_.clear_probe_stats();)
+    }
+
+    /**
+     * @brief Calls fn(const Payload&) for every entry stored under key, in input order.
+     */
+    template <typename Fn>
+    void for_each_match(int key, Fn&& fn) const {
+        const KeyRange* range = directory_.find(key);
+        if (range != nullptr) {
+            for (uint32_t i = range->begin, end = range->begin + range->count; i < end; ++i) {
+                fn(payloads_[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Starts loading the directory entry of key into cache ahead of for_each_match.
+     */
+    void prefetch(int key) const {
+        directory_.prefetch(key);
+    }
+
+    /**
+     * @brief Sizes the directory for expected_keys distinct keys before build.
+     */
+    void reserve(size_t expected_keys) {
+        directory_.reserve(expected_keys);
+    }
+
+    size_t size() const { return size_; }
+
+#ifdef HASH_TABLE_STATS
+    /**
+     * @brief The directory's counters (probes since the build) plus the payload array's bytes.
+     */
+    TableStats stats() const {
+        TableStats stats = directory_.stats();
+        stats.bytes_allocated += size_ * sizeof(Payload);
+        return stats;
+    }
+#endif
+
+private:
+    struct KeyRange {
+        uint32_t begin;
+        uint32_t count;
+    };
+
+    SwissHashMap<int, KeyRange, Hash> directory_;
+    std::unique_ptr<Payload[]> payloads_;
+    size_t size_ = 0;
+};
+
+#endif // SWISS_HASH_MAP_H
@@ -0,0 +1,118 @@
+#ifndef TABLE_SCHEMA_H
+#define TABLE_SCHEMA_H
+
+#include <cstddef>
+#include <utility>
+
+#include "csv_scan.h"
+
+// -- Schema-driven table reader --
+//
+// A schema names the row struct, the width of the text rows, the delimiter and
+// which columns land in which struct members. The reader is instantiated per
+// schema, so the per-row field loop is a fixed sequence of parse_field calls the
+// compiler can unroll and inline. Example:
+//
+//   using SchemaA = TableSchema<RowA, 2, ',', Column<0, &RowA::k>, Column<1, &RowA::v>>;
+//   scan_table<SchemaA>(begin, end, on_row, on_invalid);
+//
+// Wide rows of which only a few columns are read use a ProjectedSchema: only the
+// mapped columns are located and decoded, the rest of the line is skipped.
+
+/**
+ * @brief Maps text column `Index` to the row member `Member` (e.g. &RowA::k).
+ */
+template <size_t Index, auto Member>
+struct Column {
+    static constexpr size_t index = Index;
+    static constexpr auto member = Member;
+};
+
+/**
+ * @brief Describes a delimited text table.
+ * @tparam RowT The row struct the columns are parsed into.
+ * @tparam Width Number of fields per row; 0 accepts any row wide enough for the
+ *         mapped columns and skips the unmapped fields (projection).
+ * @tparam Delimiter The field delimiter.
+ * @tparam Columns Column<index, member> mappings, in ascending index order.
+ */
+template <typename RowT, size_t Width, char Delimiter, typename... Columns>
+struct TableSchema {
+    static_assert(Width == 0 || ((Columns::index < Width) && ...), "mapped column beyond the row width");
+
+    using Row = RowT;
+    static constexpr size_t width = Width;
+    static constexpr size_t required_width = 0;  // Exact field count of a projected row; 0 accepts any
+    static constexpr char delimiter = Delimiter;
+    static constexpr size_t num_mapped = sizeof...(Columns);
+    static constexpr size_t column_indices[] = {Columns::index...};
+
+    /**
+     * @brief Parses a full row; fields holds every field of the line.
+     */
+    static bool parse(const Field* fields, Row& row) {
+        return (parse_field(fields[Columns::index], row.*(Columns::member)) && ...);
+    }
+
+    /**
+     * @brief Parses a projected row; fields holds only the mapped fields, in order.
+     */
+    static bool parse_projected(const Field* fields, Row& row) {
+        return parse_projected(fields, row, std::make_index_sequence<sizeof...(Columns)>());
+    }
+
+private:
+    template <size_t... I>
+    static bool parse_projected(const Field* fields, Row& row, std::index_sequence<I...>) {
+        return (parse_field(fields[I], row.*(Columns::member)) && ...);
+    }
+};
+
+/**
+ * @brief A projected TableSchema (only the mapped columns are parsed) whose rows must still have
+ * exactly Width fields. Rows of another width are skipped without being reported as invalid.
+ */
+template <typename RowT, size_t Width, char Delimiter, typename... Columns>
+struct ProjectedSchema : TableSchema<RowT, 0, Delimiter, Columns...> {
+    static_assert(((Columns::index < Width) && ...), "mapped column beyond the row width");
+    static constexpr size_t required_width = Width;
+};
+
+/**
+ * @brief Parses every line of [begin, end) with Schema.
+ * @param begin Start of the buffer; must be at the beginning of a line.
+ * @param end End of the buffer.
+ * @param on_row Callable (const Schema::Row&) for each valid row.
+ * @param on_invalid Callable (Field line) for each non-blank line that does not match the schema
+ *        (for a ProjectedSchema: each line of the required width whose columns fail to parse).
+ */
+template <typename Schema, typename RowFn, typename InvalidFn>
+void scan_table(const char* begin, const char* end, RowFn&& on_row, InvalidFn&& on_invalid) {
+    static_assert(Schema::num_mapped > 0 && Schema::num_mapped <= kMaxFields, "schema maps 1..kMaxFields columns");
+    typename Schema::Row row{};
+    if constexpr (Schema::width == 0) {
+        constexpr size_t required_width = Schema::required_width;
+        scan_projected_rows(begin, end, Schema::delimiter, Schema::column_indices, Schema::num_mapped, required_width != 0,
+            [&](const Field* fields, size_t found, size_t num_fields, Field line) {
+                if (required_width != 0 && num_fields != required_width) {
+                    return;  // Another width: skipped silently, like a row of another table
+                }
+                if (found == Schema::num_mapped && Schema::parse_projected(fields, row)) {
+                    on_row(row);
+                } else if (!is_blank_line(line)) {
+                    on_invalid(line);
+                }
+            });
+    } else {
+        static_assert(Schema::width <= kMaxFields, "rows wider than kMaxFields need a projected schema");
+        scan_rows(begin, end, Schema::delimiter, [&](const Field* fields, size_t count, Field line) {
+            if (count == Schema::width && Schema::parse(fields, row)) {
+                on_row(row);
+            } else if (!is_blank_line(line)) {
+                on_invalid(line);
+            }
+        });
+    }
+}
+
+#endif // TABLE_SCHEMA_H
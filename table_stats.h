@@ -0,0 +1,76 @@
+#ifndef TABLE_STATS_H
+#define TABLE_STATS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// -- Optional hash table instrumentation --
+//
+// Built with -DHASH_TABLE_STATS, every hash table counts its lookups, hits,
+// probe lengths, resizes and allocated bytes, and the join functions print one
+// "Table Stats" line per table. Without the define TABLE_STATS(...) expands to
+// nothing, the tables carry no counters and the timed code is unchanged.
+
+#ifdef HASH_TABLE_STATS
+#define TABLE_STATS(...) __VA_ARGS__
+#else
+#define TABLE_STATS(...)
+#endif
+
+/**
+ * @brief Counters of one hash table. Probe lengths count the slots (FlatHashMap),
+ * control groups (SwissHashMap) or bucket entries (CsrHashTable) a lookup examined.
+ */
+struct TableStats {
+    static constexpr int kHistogramBuckets = 6; // 1, 2, 3-4, 5-8, 9-16, 17+
+
+    size_t lookups = 0;
+    size_t hits = 0;
+    size_t total_probe_length = 0;
+    size_t max_probe_length = 0;
+    size_t probe_histogram[kHistogramBuckets] = {};
+    size_t resizes = 0;   // Rehashes of a non-empty table; presizing an empty one is not counted
+    size_t bytes_allocated = 0;
+    size_t size = 0;      // Filled in by the table's stats()
+    size_t capacity = 0;  // Filled in by the table's stats()
+
+    void record_probe(size_t length, bool hit) {
+        ++lookups;
+        hits += hit ? 1 : 0;
+        total_probe_length += length;
+        max_probe_length = std::max(max_probe_length, length);
+        int bucket = 0;
+        while (bucket < kHistogramBuckets - 1 && length > (size_t(1) << bucket)) {
+            ++bucket;
+        }
+        probe_histogram[bucket]++;
+    }
+
+    // Forgets the lookups recorded so far (e.g. those made while building a table).
+    void clear_probes() {
+        lookups = hits = total_probe_length = max_probe_length = 0;
+        std::fill(probe_histogram, probe_histogram + kHistogramBuckets, size_t(0));
+    }
+
+    /**
+     * @brief Prints the counters as one line, labelled with the table's user.
+     */
+    void print(const std::string& label) const {
+        static const char* const kBucketNames[kHistogramBuckets] = {"1", "2", "3-4", "5-8", "9-16", "17+"};
+        std::cout << "Table Stats (" << label << "): size=" << size << " capacity=" << capacity
+                  << " load=" << (capacity > 0 ? static_cast<double>(size) / capacity : 0.0)
+                  << " resizes=" << resizes << " bytes=" << bytes_allocated
+                  << " lookups=" << lookups << " hits=" << hits << " misses=" << lookups - hits
+                  << " mean_probe=" << (lookups > 0 ? static_cast<double>(total_probe_length) / lookups : 0.0)
+                  << " max_probe=" << max_probe_length << " probe_pct=[";
+        for (int i = 0; i < kHistogramBuckets; ++i) {
+            std::cout << (i > 0 ? " " : "") << kBucketNames[i] << ":"
+                      << (lookups > 0 ? 100.0 * probe_histogram[i] / lookups : 0.0);
+        }
+        std::cout << "]" << std::endl;
+    }
+};
+
+#endif // TABLE_STATS_H
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Regression test for join_groupby.cpp: the Join-Aggregation (SUM(A.v) GROUP BY A.k) reads only
+# B's key column, so rows of B whose other columns are not integers must still join.
+# Runs in a scratch directory so the repository's A.txt and B.txt are left alone.
+
+# --- Configuration ---
+CPP_SOURCE_FILE="join_groupby.cpp"
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+echo "Compiling C++ source file: $CPP_SOURCE_FILE..."
+g++ -std=c++17 -O2 -pthread "$CPP_SOURCE_FILE" -o "$WORK_DIR/join_groupby"
+if [ $? -ne 0 ]; then
+    echo "Compilation failed. Exiting."
+    exit 1
+fi
+
+cd "$WORK_DIR" || exit 1
+
+cat > A.txt <<'DATA'
+300, 25, 'A', 1.5
+400, 20, 'A', 1.5
+600, 50, 'A', 1.5
+600, 10, 'A', 1.5
+DATA
+
+# Column 1 of the 400 row and column 2 of one 600 row are not integers.
+cat > B.txt <<'DATA'
+300, 1, 1, 'A', 1.5
+400, x, 7, 'A', 1.5
+600, 3, 2.5, 'A', 1.5
+600, 4, 4, 'A', 1.5
+DATA
+
+cat > expected.txt <<'DATA'
+
+--- Final Results (Join-Aggregation) ---
+k	|	summ
+--------------------------------
+300	|	25
+400	|	20
+600	|	120
+DATA
+
+./join_groupby > output.txt 2> errors.txt
+if [ $? -ne 0 ]; then
+    echo "FAIL: join_groupby exited with an error"
+    cat errors.txt
+    exit 1
+fi
+
+head -n "$(wc -l < expected.txt)" output.txt > actual.txt
+if ! diff -u expected.txt actual.txt; then
+    echo "FAIL: Join-Aggregation results changed"
+    exit 1
+fi
+if grep -q "RESULTS DIFFER" output.txt; then
+    echo "FAIL: eager aggregation disagrees with join-then-aggregate"
+    grep "RESULTS DIFFER" output.txt
+    exit 1
+fi
+if ! grep -q "B-side queries: 2 rows of B skipped" output.txt; then
+    echo "FAIL: expected 2 rows of B to be skipped by the B-side queries"
+    exit 1
+fi
+
+echo "PASS"